@@ -0,0 +1,90 @@
+#include "batch.h"
+
+#include <algorithm>
+
+#include "decoder.h"
+#include "encoder.h"
+
+
+/**
+ * Helper to view a message as bytes
+ * */
+static std::span<const uint8_t> asBytes(std::string_view message) {
+  return {reinterpret_cast<const uint8_t *>(message.data()), message.size()};
+}
+
+void compressBatch(std::span<const std::string_view> messages, BatchOutput & output, HuffmanContext & context,
+                   bool shareCodebook) {
+  //Size the arena once for the whole batch so the per-message path never allocates
+  size_t bound = 0;
+  for (std::string_view message : messages) {
+    bound += maxCompressedSize(message.size());
+  }
+  output.arena.resize(bound);
+  output.offsets.resize(messages.size() + 1);
+  output.sharedLengths.clear();
+
+  uint8_t * out = output.arena.data();
+  size_t pos = 0;
+
+  if (shareCodebook) {
+    //One histogram over the batch, one table build
+    std::fill(context.frequency.begin(), context.frequency.end(), 0);
+    for (std::string_view message : messages) {
+      for (uint8_t byte : asBytes(message)) {
+        context.frequency[byte]++;
+      }
+    }
+    buildCodeLengths(context.frequency, context.lengths, context.scratch);
+    buildCanonicalCodes(context.lengths, context.codes);
+    output.sharedLengths.assign(context.lengths.begin(), context.lengths.end());
+
+    EncodeTable table;
+    buildEncodeTable(context.codes, table);
+
+    for (size_t i = 0; i < messages.size(); i++) {
+      output.offsets[i] = pos;
+      pos += writeVarint(messages[i].size(), out + pos);
+      pos += encodeSymbols(asBytes(messages[i]), table, out + pos);
+    }
+  }
+  else {
+    for (size_t i = 0; i < messages.size(); i++) {
+      output.offsets[i] = pos;
+      pos += compressBuffer(asBytes(messages[i]), out + pos, context);
+    }
+  }
+
+  output.offsets[messages.size()] = pos;
+  output.arena.resize(pos);
+}
+
+bool decompressBatchMessage(const BatchOutput & batch, size_t index, std::string & out,
+                            DecodeTableCache * cache) {
+  if (index + 1 >= batch.offsets.size()) {
+    return false;
+  }
+  const uint8_t * in = batch.arena.data() + batch.offsets[index];
+  size_t size = batch.offsets[index + 1] - batch.offsets[index];
+
+  if (batch.sharedLengths.empty()) {
+    return decompressBuffer(in, size, out, cache);
+  }
+
+  uint64_t rawSize = 0;
+  size_t pos = readVarint(in, size, rawSize);
+  if (pos == 0 || rawSize > (size - pos) * 8) {
+    return false;
+  }
+  out.resize(rawSize);
+  if (rawSize == 0) {
+    return true;
+  }
+  DecodeTable local;
+  std::shared_ptr<const DecodeTable> cached;
+  const DecodeTable * table = acquireDecodeTable(batch.sharedLengths, cache, local, cached);
+  if (table == nullptr) {
+    return false;
+  }
+  return decodeSymbols(in + pos, size - pos, *table, reinterpret_cast<uint8_t *>(out.data()), rawSize);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "huffman.h"
+
+
+/**
+ * @brief Result of compressing many small messages at once.
+ * All messages are written back to back into one arena, message i lives in
+ * arena[offsets[i], offsets[i + 1]). Keep the object alive between batches to reuse its storage.
+ * */
+struct BatchOutput {
+  std::vector<uint8_t> arena;
+  std::vector<size_t> offsets;
+  std::vector<uint8_t> sharedLengths; //code lengths of the shared codebook, empty when every message has its own
+};
+
+/**
+ * @brief compress a batch of messages with one reusable context
+ * With shareCodebook one histogram and codebook are built for the whole batch and each message only
+ * stores its size and payload; otherwise every message is a standalone compressBuffer() frame.
+ * @params messages, output (overwritten), context, shareCodebook
+ * */
+void compressBatch(std::span<const std::string_view> messages, BatchOutput & output, HuffmanContext & context,
+                   bool shareCodebook);
+
+/**
+ * @brief decompress message index of a batch, the result replaces the contents of out
+ * With a cache the shared codebook's table, and any repeated per-message table, is built once.
+ * @return true on success, false if the index is out of range or the message is malformed
+ * */
+bool decompressBatchMessage(const BatchOutput & batch, size_t index, std::string & out,
+                            DecodeTableCache * cache = nullptr);
@@ -0,0 +1,494 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "batch.h"
+#include "container.h"
+#include "crc32c.h"
+#include "decoder.h"
+#include "encoder.h"
+#include "huffman.h"
+#include "lz.h"
+#include "merchant_table.h"
+#include "parallel_decode.h"
+#include "pipeline.h"
+
+
+/**
+ * Helper to read a whole file into a string
+ * */
+static std::string readFile(const std::string & path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Error opening " + path);
+  }
+  std::stringstream ss;
+  ss << file.rdbuf();
+  return ss.str();
+}
+
+/**
+ * Helper returning seconds elapsed since start
+ * */
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Helper reading the cycle counter (TSC reference cycles on x86, nanoseconds elsewhere)
+ * */
+static uint64_t cycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+/**
+ * @brief Encoder kernel: cycles per input byte of the reference encoder vs the fast kernel
+ * */
+static void benchEncoder(const std::string & corpus) {
+  std::span<const uint8_t> data(reinterpret_cast<const uint8_t *>(corpus.data()), corpus.size());
+  HuffmanContext context;
+  countFrequency(data, context.frequency);
+  buildCodeLengths(context.frequency, context.lengths, context.scratch);
+  buildCanonicalCodes(context.lengths, context.codes);
+  EncodeTable table;
+  buildEncodeTable(context.codes, table);
+
+  std::vector<uint8_t> reference(maxEncodedSize(data.size()));
+  std::vector<uint8_t> fast(maxEncodedSize(data.size()));
+  size_t referenceSize = encodeBytes(data, context.codes, reference.data());
+  size_t fastSize = encodeSymbols(data, table, fast.data());
+  if (referenceSize != fastSize || !std::equal(reference.begin(), reference.begin() + static_cast<long>(referenceSize), fast.begin())) {
+    throw std::runtime_error("Fast encoder output differs from the reference encoder");
+  }
+
+  const int rounds = 200;
+  uint64_t best[2] = {UINT64_MAX, UINT64_MAX};
+  for (int r = 0; r < rounds; r++) {
+    uint64_t start = cycleCount();
+    encodeBytes(data, context.codes, reference.data());
+    best[0] = std::min(best[0], cycleCount() - start);
+
+    start = cycleCount();
+    encodeSymbols(data, table, fast.data());
+    best[1] = std::min(best[1], cycleCount() - start);
+  }
+
+  double bytes = static_cast<double>(data.size());
+  std::cout << "encode reference: " << static_cast<double>(best[0]) / bytes << " cycles/byte" << std::endl;
+  std::cout << "encode kernel:    " << static_cast<double>(best[1]) / bytes << " cycles/byte (max code length "
+            << table.maxLength << ")" << std::endl;
+}
+
+/**
+ * @brief Hardened decoder: cycles per output byte of the reference decoder vs the table decoder
+ * */
+static void benchDecoder(const std::string & corpus) {
+  std::span<const uint8_t> data(reinterpret_cast<const uint8_t *>(corpus.data()), corpus.size());
+  HuffmanContext context;
+  countFrequency(data, context.frequency);
+  buildCodeLengths(context.frequency, context.lengths, context.scratch);
+  buildCanonicalCodes(context.lengths, context.codes);
+  std::vector<uint8_t> encoded(maxEncodedSize(data.size()));
+  size_t encodedSize = encodeBytes(data, context.codes, encoded.data());
+
+  DecodeTable table;
+  if (!buildDecodeTable(context.lengths, table)) {
+    throw std::runtime_error("Decode table rejected valid lengths");
+  }
+  std::vector<uint8_t> decoded(data.size());
+  if (!decodeSymbols(encoded.data(), encodedSize, table, decoded.data(), decoded.size()) ||
+      !std::equal(decoded.begin(), decoded.end(), data.begin())) {
+    throw std::runtime_error("Hardened decoder round trip failed");
+  }
+
+  const int rounds = 50;
+  uint64_t best[2] = {UINT64_MAX, UINT64_MAX};
+  for (int r = 0; r < rounds; r++) {
+    uint64_t start = cycleCount();
+    decodeBytes(encoded.data(), encodedSize, context.lengths, decoded.data(), decoded.size());
+    best[0] = std::min(best[0], cycleCount() - start);
+
+    start = cycleCount();
+    decodeSymbols(encoded.data(), encodedSize, table, decoded.data(), decoded.size());
+    best[1] = std::min(best[1], cycleCount() - start);
+  }
+
+  double bytes = static_cast<double>(data.size());
+  std::cout << "decode reference: " << static_cast<double>(best[0]) / bytes << " cycles/byte" << std::endl;
+  std::cout << "decode hardened:  " << static_cast<double>(best[1]) / bytes << " cycles/byte" << std::endl;
+}
+
+/**
+ * @brief Decode tables: footprint and speed per primary width with many tables live, plus cache deduplication
+ * 256 blocks of 4KB each get their own table, decoded round robin so the tables compete for cache.
+ * */
+static void benchDecodeTables(const std::string & corpus) {
+  const size_t blockSize = 4096;
+  const size_t blockCount = 256;
+  std::string input;
+  while (input.size() < blockSize * blockCount) {
+    input += corpus;
+  }
+
+  struct Block {
+    std::vector<uint8_t> lengths;
+    std::vector<uint8_t> payload;
+    size_t payloadSize;
+  };
+  std::vector<Block> blocks(blockCount);
+  HuffmanContext context;
+  EncodeTable encodeTable;
+  for (size_t i = 0; i < blockCount; i++) {
+    std::span<const uint8_t> data(reinterpret_cast<const uint8_t *>(input.data()) + i * blockSize, blockSize);
+    countFrequency(data, context.frequency);
+    buildCodeLengths(context.frequency, context.lengths, context.scratch);
+    buildCanonicalCodes(context.lengths, context.codes);
+    buildEncodeTable(context.codes, encodeTable);
+    blocks[i].lengths = context.lengths;
+    blocks[i].payload.resize(maxEncodedSize(blockSize));
+    blocks[i].payloadSize = encodeSymbols(data, encodeTable, blocks[i].payload.data());
+  }
+
+  std::vector<uint8_t> decoded(blockSize);
+  for (int lookupBits : {8, 10, 12, MAX_CODE_LENGTH}) {
+    std::vector<DecodeTable> tables(blockCount);
+    size_t footprint = 0;
+    for (size_t i = 0; i < blockCount; i++) {
+      buildDecodeTable(blocks[i].lengths, tables[i], lookupBits);
+      footprint += tables[i].footprint();
+    }
+
+    const int rounds = 20;
+    uint64_t start = cycleCount();
+    for (int r = 0; r < rounds; r++) {
+      for (size_t i = 0; i < blockCount; i++) {
+        if (!decodeSymbols(blocks[i].payload.data(), blocks[i].payloadSize, tables[i], decoded.data(), blockSize) ||
+            !std::equal(decoded.begin(), decoded.end(), input.begin() + static_cast<long>(i * blockSize))) {
+          throw std::runtime_error("Decode table round trip failed");
+        }
+      }
+    }
+    double cycles = static_cast<double>(cycleCount() - start);
+    std::cout << "decode tables " << lookupBits << "-bit primary: " << footprint / blockCount << " bytes/table, "
+              << footprint / 1024 << " KB live, " << cycles / (static_cast<double>(rounds * blockCount * blockSize))
+              << " cycles/byte" << std::endl;
+  }
+
+  DecodeTableCache cache;
+  for (const Block & block : blocks) {
+    cache.get(block.lengths);
+  }
+  std::cout << "decode table cache: " << cache.misses() << " tables built for " << blockCount << " blocks ("
+            << cache.hits() << " hits), " << cache.footprint() / 1024 << " KB" << std::endl;
+}
+
+/**
+ * @brief Parallel decode of one large block at several thread counts
+ * */
+static void benchParallelDecode(const std::string & corpus) {
+  //One 16MB block
+  std::string input;
+  while (input.size() < (16u << 20)) {
+    input += corpus;
+  }
+  std::vector<uint8_t> compressed(maxCompressedSize(input.size()));
+  HuffmanContext context;
+  size_t size = compressBuffer({reinterpret_cast<const uint8_t *>(input.data()), input.size()}, compressed.data(), context);
+
+  std::string decoded;
+  unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  for (int threads : {1, 2, 4, 8}) {
+    auto start = std::chrono::steady_clock::now();
+    if (!decompressBufferParallel(compressed.data(), size, decoded, threads) || decoded != input) {
+      throw std::runtime_error("Parallel decode round trip failed");
+    }
+    double seconds = secondsSince(start);
+    std::cout << "parallel decode " << threads << " threads (" << cores << " cores): "
+              << static_cast<double>(input.size()) / seconds / 1e6 << " MB/s" << std::endl;
+  }
+}
+
+/**
+ * @brief Static codebook: compile-time merchant.txt tables vs building the same tables at runtime
+ * */
+static void benchStatic(const std::string & corpus) {
+  std::span<const uint8_t> data(reinterpret_cast<const uint8_t *>(corpus.data()), corpus.size());
+  std::vector<uint8_t> encoded(maxEncodedSize(data.size()));
+  std::vector<uint8_t> decoded(data.size());
+
+  size_t encodedSize = staticEncode<MERCHANT_CODEBOOK>(data, encoded.data());
+  if (!staticDecode<MERCHANT_CODEBOOK>(encoded.data(), encodedSize, decoded.data(), decoded.size()) ||
+      !std::equal(decoded.begin(), decoded.end(), data.begin())) {
+    throw std::runtime_error("Static codec round trip failed");
+  }
+  //The static stream is a plain canonical stream, the generic decoder must agree
+  if (!decodeBytes(encoded.data(), encodedSize, MERCHANT_CODEBOOK.lengths, decoded.data(), decoded.size()) ||
+      !std::equal(decoded.begin(), decoded.end(), data.begin())) {
+    throw std::runtime_error("Static stream rejected by decodeBytes");
+  }
+
+  const int rounds = 200;
+  uint64_t best[3] = {UINT64_MAX, UINT64_MAX, UINT64_MAX};
+  HuffmanContext context;
+  EncodeTable table;
+  for (int r = 0; r < rounds; r++) {
+    uint64_t start = cycleCount();
+    std::vector<int> frequency(MERCHANT_FREQUENCY.begin(), MERCHANT_FREQUENCY.end());
+    buildCodeLengths(frequency, context.lengths, context.scratch);
+    buildCanonicalCodes(context.lengths, context.codes);
+    buildEncodeTable(context.codes, table);
+    best[0] = std::min(best[0], cycleCount() - start);
+
+    start = cycleCount();
+    staticEncode<MERCHANT_CODEBOOK>(data, encoded.data());
+    best[1] = std::min(best[1], cycleCount() - start);
+
+    start = cycleCount();
+    staticDecode<MERCHANT_CODEBOOK>(encoded.data(), encodedSize, decoded.data(), decoded.size());
+    best[2] = std::min(best[2], cycleCount() - start);
+  }
+
+  double bytes = static_cast<double>(data.size());
+  std::cout << "static runtime table build avoided: " << best[0] << " cycles" << std::endl;
+  std::cout << "static encode: " << static_cast<double>(best[1]) / bytes << " cycles/byte, decode: "
+            << static_cast<double>(best[2]) / bytes << " cycles/byte (longest code " << MERCHANT_CODEBOOK.longest
+            << ", ratio " << static_cast<double>(encodedSize) / bytes << ")" << std::endl;
+}
+
+/**
+ * @brief Levels: ratio against compression and decompression speed for each compressLevel() level
+ * */
+static void benchLevels(const std::string & corpus) {
+  std::span<const uint8_t> data(reinterpret_cast<const uint8_t *>(corpus.data()), corpus.size());
+  std::vector<uint8_t> out(maxLevelCompressedSize(data.size()));
+  LzContext context;
+  std::string decoded;
+
+  for (int level = 0; level <= MAX_LEVEL; level++) {
+    const int rounds = 20;
+    size_t size = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+      size = compressLevel(data, out.data(), level, context);
+    }
+    double compressSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+      if (!decompressLevel(out.data(), size, decoded) || decoded != corpus) {
+        throw std::runtime_error("Level round trip failed");
+      }
+    }
+    double decompressSeconds = secondsSince(start);
+
+    double megabytes = static_cast<double>(corpus.size()) * rounds / 1e6;
+    std::cout << "level " << level << ": ratio " << static_cast<double>(size) / static_cast<double>(corpus.size())
+              << ", compress " << megabytes / compressSeconds << " MB/s, decompress "
+              << megabytes / decompressSeconds << " MB/s" << std::endl;
+  }
+}
+
+/**
+ * @brief Batch API: split the corpus into 100 byte - 4KB messages and report time per message
+ * */
+static void benchBatch(const std::string & corpus) {
+  //Message sizes cycle through 100B..4KB so both ends of the workload are covered
+  std::vector<std::string_view> messages;
+  const size_t sizes[] = {100, 250, 600, 1500, 4096};
+  size_t pos = 0;
+  for (size_t i = 0; pos < corpus.size(); i++) {
+    size_t len = std::min(sizes[i % 5], corpus.size() - pos);
+    messages.push_back(std::string_view(corpus).substr(pos, len));
+    pos += len;
+  }
+
+  HuffmanContext context;
+  BatchOutput output;
+  for (bool shared : {false, true}) {
+    compressBatch(messages, output, context, shared); //warm up the context and arena
+
+    const int rounds = 50;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+      compressBatch(messages, output, context, shared);
+    }
+    double seconds = secondsSince(start);
+
+    std::string decoded;
+    for (size_t i = 0; i < messages.size(); i++) {
+      if (!decompressBatchMessage(output, i, decoded) || decoded != messages[i]) {
+        throw std::runtime_error("Batch round trip failed");
+      }
+    }
+
+    double perMessage = seconds * 1e9 / (static_cast<double>(rounds) * static_cast<double>(messages.size()));
+    std::cout << "batch " << (shared ? "shared codebook " : "own codebook    ")
+              << messages.size() << " msgs: " << perMessage << " ns/msg, "
+              << corpus.size() * rounds / seconds / 1e6 << " MB/s, ratio "
+              << static_cast<double>(output.arena.size()) / static_cast<double>(corpus.size()) << std::endl;
+  }
+}
+
+/**
+ * @brief Pipelined file compression: compare wall time with I/O alone and compute alone at several queue depths
+ * A pipeline that overlaps well lands close to 1x max(I/O, compute).
+ * */
+static void benchPipeline(const std::string & corpus) {
+  //About 32MB of input so several blocks are in flight
+  const std::string inputPath = "bench_pipeline.in";
+  const std::string outputPath = "bench_pipeline.out";
+  {
+    std::ofstream file(inputPath, std::ios::binary);
+    for (size_t written = 0; written < (32u << 20); written += corpus.size()) {
+      file << corpus;
+    }
+  }
+  std::string input = readFile(inputPath);
+
+  //Same block work compressFile() does with default options: container block header, method byte, CRC
+  const size_t blockSize = 1 << 20;
+  ContainerHeader header;
+  header.blockSize = static_cast<uint32_t>(blockSize);
+  LzContext context;
+  std::vector<uint8_t> out(maxBlockFrameSize(blockSize));
+  std::vector<size_t> frameSizes;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t pos = 0; pos < input.size(); pos += blockSize) {
+    size_t len = std::min(blockSize, input.size() - pos);
+    frameSizes.push_back(
+        encodeBlock({reinterpret_cast<const uint8_t *>(input.data()) + pos, len}, out.data(), header, context));
+  }
+  double computeSeconds = secondsSince(start);
+
+  //Same reads and writes with no compute in between: every block read, a frame of the real size written
+  std::vector<uint8_t> block(blockSize);
+  start = std::chrono::steady_clock::now();
+  {
+    int inputFd = ::open(inputPath.c_str(), O_RDONLY);
+    int outputFd = ::open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (inputFd < 0 || outputFd < 0) {
+      throw std::runtime_error("Error opening pipeline bench files");
+    }
+    uint64_t offset = 0;
+    uint64_t writeOffset = 0;
+    for (size_t frameSize : frameSizes) {
+      ssize_t got = ::pread(inputFd, block.data(), blockSize, static_cast<off_t>(offset));
+      ssize_t put = ::pwrite(outputFd, out.data(), frameSize, static_cast<off_t>(writeOffset));
+      if (got <= 0 || put != static_cast<ssize_t>(frameSize)) {
+        throw std::runtime_error("Pipeline bench I/O failed");
+      }
+      offset += static_cast<uint64_t>(got);
+      writeOffset += frameSize;
+    }
+    ::close(inputFd);
+    ::close(outputFd);
+  }
+  double ioSeconds = secondsSince(start);
+  double bound = std::max(ioSeconds, computeSeconds);
+
+  std::cout << "pipeline compute only:          " << computeSeconds * 1e3 << " ms" << std::endl;
+  std::cout << "pipeline I/O only:              " << ioSeconds * 1e3 << " ms" << std::endl;
+  for (bool useIoUring : {false, true}) {
+    for (int depth : {1, 2, 3}) {
+      PipelineOptions options;
+      options.blockSize = blockSize;
+      options.queueDepth = depth;
+      options.useIoUring = useIoUring;
+      start = std::chrono::steady_clock::now();
+      PipelineResult result = compressFile(inputPath, outputPath, options);
+      double seconds = secondsSince(start);
+      std::cout << "pipeline " << (result.usedIoUring ? "io_uring" : "threads ") << " depth " << depth << ":     "
+                << seconds * 1e3 << " ms, " << seconds / bound << "x max(I/O, compute)" << std::endl;
+    }
+  }
+  std::remove(inputPath.c_str());
+  std::remove(outputPath.c_str());
+}
+
+/**
+ * CRC32C throughput and what the per-block checksum adds to level 0 compress/decompress
+ * */
+static void benchChecksum(const std::string & corpus) {
+  std::span<const uint8_t> data(reinterpret_cast<const uint8_t *>(corpus.data()), corpus.size());
+  HuffmanContext context;
+  std::vector<uint8_t> compressed(maxCompressedSize(data.size()));
+  uint32_t checksum = 0;
+  size_t compressedSize = compressBuffer(data, compressed.data(), context, &checksum);
+  std::string decoded;
+  uint32_t decodedChecksum = 0;
+  if (checksum != crc32c(data.data(), data.size()) ||
+      !decompressBuffer(compressed.data(), compressedSize, decoded, nullptr, &decodedChecksum) ||
+      decodedChecksum != checksum || decoded != corpus) {
+    throw std::runtime_error("Checksummed round trip failed");
+  }
+
+  const int rounds = 20;
+  uint64_t crcBest = UINT64_MAX;
+  uint64_t compressBest[2] = {UINT64_MAX, UINT64_MAX};
+  uint64_t decompressBest[2] = {UINT64_MAX, UINT64_MAX};
+  for (int r = 0; r < rounds; r++) {
+    uint64_t start = cycleCount();
+    checksum = crc32c(data.data(), data.size());
+    crcBest = std::min(crcBest, cycleCount() - start);
+
+    for (int withCrc = 0; withCrc < 2; withCrc++) {
+      start = cycleCount();
+      compressBuffer(data, compressed.data(), context, withCrc ? &checksum : nullptr);
+      compressBest[withCrc] = std::min(compressBest[withCrc], cycleCount() - start);
+
+      start = cycleCount();
+      decompressBuffer(compressed.data(), compressedSize, decoded, nullptr, withCrc ? &decodedChecksum : nullptr);
+      decompressBest[withCrc] = std::min(decompressBest[withCrc], cycleCount() - start);
+    }
+  }
+
+  double bytes = static_cast<double>(data.size());
+  auto overhead = [](const uint64_t best[2]) {
+    return 100.0 * (static_cast<double>(best[1]) - static_cast<double>(best[0])) / static_cast<double>(best[0]);
+  };
+  std::cout << "crc32c " << (crc32cHardware() ? "sse4.2:   " : "software: ") << static_cast<double>(crcBest) / bytes
+            << " cycles/byte" << std::endl;
+  std::cout << "checksum overhead: compress " << overhead(compressBest) << "%, decompress "
+            << overhead(decompressBest) << "%" << std::endl;
+}
+
+int main(int argc, char * argv[]) {
+  std::string path = argc > 1 ? argv[1] : "merchant.txt";
+  try {
+    std::string corpus = readFile(path);
+    std::cout << "corpus: " << path << " (" << corpus.size() << " bytes)" << std::endl;
+    benchEncoder(corpus);
+    benchDecoder(corpus);
+    benchDecodeTables(corpus);
+    benchParallelDecode(corpus);
+    benchStatic(corpus);
+    benchLevels(corpus);
+    benchBatch(corpus);
+    benchChecksum(corpus);
+    benchPipeline(corpus);
+  }
+  catch (const std::exception & e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
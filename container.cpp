@@ -0,0 +1,113 @@
+#include "container.h"
+
+#include <cstring>
+
+#include "crc32c.h"
+#include "merchant_table.h"
+
+
+void storeLE32(uint8_t * out, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    out[i] = static_cast<uint8_t>(value >> (8 * i));
+  }
+}
+
+uint32_t loadLE32(const uint8_t * in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    value |= static_cast<uint32_t>(in[i]) << (8 * i);
+  }
+  return value;
+}
+
+void writeContainerHeader(const ContainerHeader & header, uint8_t * out) {
+  std::memcpy(out, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+  out[4] = header.version;
+  out[5] = header.flags;
+  out[6] = static_cast<uint8_t>(header.tableType);
+  out[7] = header.level;
+  storeLE32(out + 8, header.blockSize);
+  storeLE32(out + 12, crc32c(out, 12));
+}
+
+bool readContainerHeader(const uint8_t * in, ContainerHeader & header) {
+  if (std::memcmp(in, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) != 0 || loadLE32(in + 12) != crc32c(in, 12)) {
+    return false;
+  }
+  header.version = in[4];
+  header.flags = in[5];
+  header.tableType = static_cast<TableType>(in[6]);
+  header.level = in[7];
+  header.blockSize = loadLE32(in + 8);
+
+  //Newer versions and flags this build does not know are rejected rather than misread
+  if (header.version != CONTAINER_VERSION || (header.flags & ~CONTAINER_FLAG_BLOCK_CHECKSUMS) != 0) {
+    return false;
+  }
+  if (header.tableType != TableType::Dynamic && header.tableType != TableType::StaticMerchant) {
+    return false;
+  }
+  return header.level <= MAX_LEVEL && header.blockSize > 0 && header.blockSize <= MAX_CONTAINER_BLOCK_SIZE;
+}
+
+void writeBlockHeader(const BlockHeader & block, uint8_t * out) {
+  storeLE32(out, block.compressedSize);
+  storeLE32(out + 4, block.uncompressedSize);
+  storeLE32(out + 8, block.checksum);
+}
+
+BlockHeader readBlockHeader(const uint8_t * in) {
+  return BlockHeader{loadLE32(in), loadLE32(in + 4), loadLE32(in + 8)};
+}
+
+size_t encodeBlock(std::span<const uint8_t> data, uint8_t * out, const ContainerHeader & header, LzContext & context) {
+  bool checksums = (header.flags & CONTAINER_FLAG_BLOCK_CHECKSUMS) != 0;
+  BlockHeader block;
+  block.uncompressedSize = static_cast<uint32_t>(data.size());
+
+  size_t payloadSize = 0;
+  uint8_t * payload = out + BLOCK_HEADER_SIZE;
+  if (header.tableType == TableType::StaticMerchant) {
+    payloadSize = staticEncode<MERCHANT_CODEBOOK>(data, payload);
+    if (checksums) {
+      block.checksum = crc32c(data.data(), data.size());
+    }
+  }
+  else {
+    payloadSize = compressLevel(data, payload, header.level, context, checksums ? &block.checksum : nullptr);
+  }
+
+  block.compressedSize = static_cast<uint32_t>(payloadSize);
+  writeBlockHeader(block, out);
+  return BLOCK_HEADER_SIZE + payloadSize;
+}
+
+BlockStatus decodeBlock(const BlockHeader & block, const uint8_t * payload, const ContainerHeader & header,
+                        std::string & out, DecodeTableCache * cache, int threads) {
+  bool checksums = (header.flags & CONTAINER_FLAG_BLOCK_CHECKSUMS) != 0;
+  uint32_t checksum = 0;
+
+  if (header.tableType == TableType::StaticMerchant) {
+    out.resize(block.uncompressedSize);
+    if (!staticDecode<MERCHANT_CODEBOOK>(payload, block.compressedSize, reinterpret_cast<uint8_t *>(out.data()),
+                                         out.size())) {
+      return BlockStatus::Corrupt;
+    }
+    if (checksums) {
+      checksum = crc32c(reinterpret_cast<const uint8_t *>(out.data()), out.size());
+    }
+  }
+  //The frame's own size field must agree with the block header before the decoder allocates anything
+  else if (!decompressLevel(payload, block.compressedSize, out, cache, checksums ? &checksum : nullptr, threads,
+                            block.uncompressedSize)) {
+    return BlockStatus::Corrupt;
+  }
+
+  if (out.size() != block.uncompressedSize) {
+    return BlockStatus::Corrupt;
+  }
+  if (checksums && checksum != block.checksum) {
+    return BlockStatus::ChecksumMismatch;
+  }
+  return BlockStatus::Ok;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+#include "lz.h"
+
+
+/**
+ * On-disk layout written by compressFile(), all integers little-endian:
+ *
+ *   file header (16 bytes)
+ *     0  magic "HUFZ"
+ *     4  version
+ *     5  flags (CONTAINER_FLAG_*)
+ *     6  table type (TableType)
+ *     7  compressLevel() level, 0 for static tables
+ *     8  block size, the largest uncompressed size of any block
+ *    12  CRC32C of bytes 0..11
+ *   blocks, each a 12-byte header followed by compressedSize bytes of payload
+ *     0  compressed size
+ *     4  uncompressed size
+ *     8  CRC32C of the uncompressed block, 0 without CONTAINER_FLAG_BLOCK_CHECKSUMS
+ *   end marker: a block header of all zeros
+ *
+ * The end marker lets a reader tell a file cut at a block boundary from a complete one.
+ * */
+constexpr uint8_t CONTAINER_MAGIC[4] = {'H', 'U', 'F', 'Z'};
+constexpr uint8_t CONTAINER_VERSION = 1;
+constexpr size_t CONTAINER_HEADER_SIZE = 16;
+constexpr size_t BLOCK_HEADER_SIZE = 12;
+
+//Every block carries the CRC32C of its uncompressed bytes
+constexpr uint8_t CONTAINER_FLAG_BLOCK_CHECKSUMS = 1;
+
+//Largest block a container may declare, guards buffer sizes against corrupt headers
+constexpr uint32_t MAX_CONTAINER_BLOCK_SIZE = 1u << 28;
+
+/**
+ * @brief How block payloads are coded
+ * Dynamic blocks are compressLevel() frames with their own tables, static blocks are a bare
+ * staticEncode() stream of the built-in merchant codebook.
+ * */
+enum class TableType : uint8_t { Dynamic = 0, StaticMerchant = 1 };
+
+struct ContainerHeader {
+  uint8_t version = CONTAINER_VERSION;
+  uint8_t flags = CONTAINER_FLAG_BLOCK_CHECKSUMS;
+  TableType tableType = TableType::Dynamic;
+  uint8_t level = 0;
+  uint32_t blockSize = 1 << 20;
+};
+
+struct BlockHeader {
+  uint32_t compressedSize = 0;
+  uint32_t uncompressedSize = 0;
+  uint32_t checksum = 0;
+};
+
+/**
+ * @brief Result of decodeBlock, kept apart so a bad checksum can be reported as such
+ * */
+enum class BlockStatus { Ok, Corrupt, ChecksumMismatch };
+
+/**
+ * Little-endian helpers for the header fields
+ * */
+void storeLE32(uint8_t * out, uint32_t value);
+uint32_t loadLE32(const uint8_t * in);
+
+/**
+ * @brief serialize a file header into CONTAINER_HEADER_SIZE bytes
+ * */
+void writeContainerHeader(const ContainerHeader & header, uint8_t * out);
+
+/**
+ * @brief parse a file header
+ * @return false on a wrong magic, an unsupported version, unknown flags or table type, or a bad header checksum
+ * */
+bool readContainerHeader(const uint8_t * in, ContainerHeader & header);
+
+/**
+ * @brief serialize / parse a block header of BLOCK_HEADER_SIZE bytes
+ * */
+void writeBlockHeader(const BlockHeader & block, uint8_t * out);
+BlockHeader readBlockHeader(const uint8_t * in);
+
+/**
+ * @brief worst case size of encodeBlock output, header included
+ * */
+constexpr size_t maxBlockFrameSize(size_t blockSize) {
+  return BLOCK_HEADER_SIZE + maxLevelCompressedSize(blockSize);
+}
+
+/**
+ * @brief write one block (header + payload) as the container header describes
+ * The checksum is computed while the block is compressed, not in a separate pass, where the coder allows it.
+ * @params data (at most header.blockSize bytes, not empty), out (room for maxBlockFrameSize(header.blockSize)), header, context
+ * @return number of bytes written
+ * */
+size_t encodeBlock(std::span<const uint8_t> data, uint8_t * out, const ContainerHeader & header, LzContext & context);
+
+/**
+ * @brief decode one block payload into out and check it against its block header
+ * @params block, payload (block.compressedSize bytes), header, out, cache shared between blocks,
+ *          threads for large level 0 blocks (see decompressLevel)
+ * @return Ok, Corrupt if the payload does not decode to uncompressedSize bytes, ChecksumMismatch otherwise
+ * */
+BlockStatus decodeBlock(const BlockHeader & block, const uint8_t * payload, const ContainerHeader & header,
+                        std::string & out, DecodeTableCache * cache = nullptr, int threads = 1);
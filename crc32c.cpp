@@ -0,0 +1,142 @@
+#include "crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#include "huffman.h"
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#define HUFFMAN_HAVE_SSE42_CRC 1
+#endif
+
+
+//Reflected CRC32C polynomial
+constexpr uint32_t CRC32C_POLY = 0x82F63B78u;
+
+/**
+ * Helper building the slicing-by-8 tables at compile time
+ * table[k][b] is the CRC of byte b followed by k zero bytes
+ * */
+constexpr std::array<std::array<uint32_t, 256>, 8> makeCrcTables() {
+  std::array<std::array<uint32_t, 256>, 8> tables{};
+  for (uint32_t byte = 0; byte < 256; byte++) {
+    uint32_t crc = byte;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+    }
+    tables[0][byte] = crc;
+  }
+  for (size_t k = 1; k < 8; k++) {
+    for (size_t byte = 0; byte < 256; byte++) {
+      uint32_t previous = tables[k - 1][byte];
+      tables[k][byte] = (previous >> 8) ^ tables[0][previous & 0xFF];
+    }
+  }
+  return tables;
+}
+
+constexpr std::array<std::array<uint32_t, 256>, 8> CRC_TABLES = makeCrcTables();
+
+/**
+ * Helper: portable slicing-by-8 update on the raw (not inverted) CRC state
+ * */
+static uint32_t crc32cSoftware(uint32_t crc, const uint8_t * data, size_t size) {
+  while (size >= 8) {
+    uint32_t low = crc ^ (static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+                          static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24);
+    crc = CRC_TABLES[7][low & 0xFF] ^ CRC_TABLES[6][(low >> 8) & 0xFF] ^ CRC_TABLES[5][(low >> 16) & 0xFF] ^
+          CRC_TABLES[4][low >> 24] ^ CRC_TABLES[3][data[4]] ^ CRC_TABLES[2][data[5]] ^ CRC_TABLES[1][data[6]] ^
+          CRC_TABLES[0][data[7]];
+    data += 8;
+    size -= 8;
+  }
+  while (size-- > 0) {
+    crc = (crc >> 8) ^ CRC_TABLES[0][(crc ^ *data++) & 0xFF];
+  }
+  return crc;
+}
+
+#ifdef HUFFMAN_HAVE_SSE42_CRC
+/**
+ * Helper: SSE4.2 update, one crc32 instruction per 8 bytes
+ * */
+__attribute__((target("sse4.2"))) static uint32_t crc32cSse42(uint32_t crc, const uint8_t * data, size_t size) {
+  uint64_t state = crc;
+  while (size >= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    state = _mm_crc32_u64(state, word);
+    data += 8;
+    size -= 8;
+  }
+  crc = static_cast<uint32_t>(state);
+  while (size-- > 0) {
+    crc = _mm_crc32_u8(crc, *data++);
+  }
+  return crc;
+}
+
+/**
+ * Helper: fused histogram + SSE4.2 CRC
+ * The word feeds the crc32 instruction while the histogram uses plain byte loads into 4 interleaved
+ * tables, so repeated bytes do not serialize on one counter and there is no shift/mask per byte.
+ * */
+__attribute__((target("sse4.2"))) static uint32_t countCrcSse42(uint32_t crc, const uint8_t * data, size_t size,
+                                                                 int * frequency) {
+  uint32_t counts[4][ALPHABET_SIZE] = {};
+  uint64_t state = crc;
+  while (size >= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    state = _mm_crc32_u64(state, word);
+    counts[0][data[0]]++;
+    counts[1][data[1]]++;
+    counts[2][data[2]]++;
+    counts[3][data[3]]++;
+    counts[0][data[4]]++;
+    counts[1][data[5]]++;
+    counts[2][data[6]]++;
+    counts[3][data[7]]++;
+    data += 8;
+    size -= 8;
+  }
+  crc = static_cast<uint32_t>(state);
+  while (size-- > 0) {
+    counts[0][*data]++;
+    crc = _mm_crc32_u8(crc, *data++);
+  }
+  for (int symbol = 0; symbol < ALPHABET_SIZE; symbol++) {
+    frequency[symbol] = static_cast<int>(counts[0][symbol] + counts[1][symbol] + counts[2][symbol] + counts[3][symbol]);
+  }
+  return crc;
+}
+#endif
+
+bool crc32cHardware() {
+#ifdef HUFFMAN_HAVE_SSE42_CRC
+  static const bool hasSse42 = __builtin_cpu_supports("sse4.2");
+  return hasSse42;
+#else
+  return false;
+#endif
+}
+
+uint32_t crc32c(const uint8_t * data, size_t size, uint32_t crc) {
+#ifdef HUFFMAN_HAVE_SSE42_CRC
+  if (crc32cHardware()) {
+    return ~crc32cSse42(~crc, data, size);
+  }
+#endif
+  return ~crc32cSoftware(~crc, data, size);
+}
+
+uint32_t countFrequencyCrc32c(std::span<const uint8_t> data, std::span<int> frequency) {
+#ifdef HUFFMAN_HAVE_SSE42_CRC
+  if (crc32cHardware() && frequency.size() == ALPHABET_SIZE) {
+    return ~countCrcSse42(~0u, data.data(), data.size(), frequency.data());
+  }
+#endif
+  countFrequency(data, frequency);
+  return crc32c(data.data(), data.size());
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+
+/**
+ * @brief CRC32C (Castagnoli) of size bytes, continuing from a previous result (0 to start)
+ * Uses the SSE4.2 crc32 instruction when the CPU has it, slicing-by-8 tables otherwise.
+ * */
+uint32_t crc32c(const uint8_t * data, size_t size, uint32_t crc = 0);
+
+/**
+ * @brief true if crc32c() runs on the SSE4.2 instruction
+ * */
+bool crc32cHardware();
+
+/**
+ * @brief countFrequency() and crc32c() in one pass over the data
+ * Each 8-byte word goes to the crc32 instruction while its bytes are counted into 4 interleaved histograms,
+ * which is cheaper than countFrequency() followed by crc32c().
+ * @params data, frequency (reset first)
+ * @return CRC32C of data
+ * */
+uint32_t countFrequencyCrc32c(std::span<const uint8_t> data, std::span<int> frequency);
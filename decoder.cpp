@@ -0,0 +1,193 @@
+#include "decoder.h"
+
+#include <algorithm>
+
+#include "crc32c.h"
+
+
+bool buildDecodeTable(std::span<const uint8_t> lengths, DecodeTable & table, int lookupBits) {
+  if (lengths.size() > 4096) {
+    return false;
+  }
+
+  int lengthCount[MAX_CODE_LENGTH + 1] = {0};
+  int codes = 0;
+  int longest = 0;
+  int shortest = MAX_CODE_LENGTH;
+  for (uint8_t len : lengths) {
+    if (len > MAX_CODE_LENGTH) {
+      return false;
+    }
+    if (len > 0) {
+      lengthCount[len]++;
+      codes++;
+      longest = std::max(longest, static_cast<int>(len));
+      shortest = std::min(shortest, static_cast<int>(len));
+    }
+  }
+  if (codes == 0) {
+    return false;
+  }
+
+  //Kraft sum in units of 2^-len: codes left unused at each length
+  int left = 1;
+  for (int len = 1; len <= MAX_CODE_LENGTH; len++) {
+    left <<= 1;
+    left -= lengthCount[len];
+    if (left < 0) {
+      return false; //over-subscribed
+    }
+  }
+  if (left > 0 && !(codes == 1 && longest == 1)) {
+    return false; //incomplete
+  }
+
+  //Primary table never wider than the longest code
+  int primaryBits = std::clamp(lookupBits, 1, longest);
+  table.lookupBits = primaryBits;
+  table.mask = (uint64_t{1} << primaryBits) - 1;
+  table.subtableBits = longest - primaryBits;
+  table.longest = longest;
+  table.shortest = shortest;
+
+  uint32_t nextCode[MAX_CODE_LENGTH + 1] = {0};
+  uint32_t code = 0;
+  for (int bits = 1; bits <= MAX_CODE_LENGTH; bits++) {
+    code = (code + static_cast<uint32_t>(lengthCount[bits - 1])) << 1;
+    nextCode[bits] = code;
+  }
+
+  //Subtables only for primary prefixes that long codes actually use
+  const size_t primarySize = size_t{1} << primaryBits;
+  const size_t subtableSize = size_t{1} << table.subtableBits;
+  //0xFFFF marks primary slots not claimed yet; a complete code overwrites every one of them
+  const uint16_t unclaimed = 0xFFFF;
+  table.entries.assign(primarySize, unclaimed);
+  int subtables = 0;
+
+  for (size_t symbol = 0; symbol < lengths.size(); symbol++) {
+    int len = lengths[symbol];
+    if (len == 0) {
+      continue;
+    }
+    uint32_t reversed = reverseBits(nextCode[len]++, len);
+    uint16_t entry = static_cast<uint16_t>(len | (symbol << 4));
+
+    if (len <= primaryBits) {
+      //A lone 1-bit code also takes the unused half so every entry decodes to something
+      uint32_t step = codes == 1 ? 1 : (1u << len);
+      for (size_t index = reversed; index < primarySize; index += step) {
+        table.entries[index] = entry;
+      }
+      continue;
+    }
+
+    size_t prefix = reversed & table.mask;
+    if (table.entries[prefix] == unclaimed) {
+      table.entries[prefix] = static_cast<uint16_t>(subtables++ << 4);
+      table.entries.resize(table.entries.size() + subtableSize, 0);
+    }
+    size_t base = primarySize + (static_cast<size_t>(table.entries[prefix] >> 4) << table.subtableBits);
+    for (size_t index = reversed >> primaryBits; index < subtableSize; index += size_t{1} << (len - primaryBits)) {
+      table.entries[base + index] = entry;
+    }
+  }
+  return true;
+}
+
+std::shared_ptr<const DecodeTable> DecodeTableCache::get(std::span<const uint8_t> lengths) {
+  std::string key(reinterpret_cast<const char *>(lengths.data()), lengths.size());
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = tables.find(key);
+    if (found != tables.end()) {
+      hitCount++;
+      return found->second;
+    }
+    missCount++;
+  }
+
+  //Build outside the lock, another thread may race us to the same key and that is fine
+  auto table = std::make_shared<DecodeTable>();
+  if (!buildDecodeTable(lengths, *table, primaryBits)) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (tables.size() >= capacity && !tables.empty()) {
+    tables.erase(tables.begin());
+  }
+  tables.emplace(std::move(key), table);
+  return table;
+}
+
+size_t DecodeTableCache::footprint() {
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t bytes = 0;
+  for (const auto & entry : tables) {
+    bytes += entry.second->footprint();
+  }
+  return bytes;
+}
+
+const DecodeTable * acquireDecodeTable(std::span<const uint8_t> lengths, DecodeTableCache * cache, DecodeTable & local,
+                                       std::shared_ptr<const DecodeTable> & holder, int lookupBits) {
+  if (cache != nullptr) {
+    holder = cache->get(lengths);
+    return holder.get();
+  }
+  return buildDecodeTable(lengths, local, lookupBits) ? &local : nullptr;
+}
+
+/**
+ * Helper decoding count symbols from an already positioned reader, shared by the plain and checksummed decoders
+ * */
+static void decodeRun(BitReader & reader, const DecodeTable & table, uint8_t * out, size_t count) {
+  size_t i = 0;
+
+  //One refill covers 4 codes of up to 14 bits, or 3 of 15 bits
+  static_assert(4 * 14 <= MIN_REFILL_BITS && 3 * MAX_CODE_LENGTH <= MIN_REFILL_BITS);
+  if (table.longest <= 14) {
+    for (; i + 4 <= count; i += 4) {
+      reader.refill();
+      out[i] = static_cast<uint8_t>(decodeSymbol(reader, table));
+      out[i + 1] = static_cast<uint8_t>(decodeSymbol(reader, table));
+      out[i + 2] = static_cast<uint8_t>(decodeSymbol(reader, table));
+      out[i + 3] = static_cast<uint8_t>(decodeSymbol(reader, table));
+    }
+  }
+  else {
+    for (; i + 3 <= count; i += 3) {
+      reader.refill();
+      out[i] = static_cast<uint8_t>(decodeSymbol(reader, table));
+      out[i + 1] = static_cast<uint8_t>(decodeSymbol(reader, table));
+      out[i + 2] = static_cast<uint8_t>(decodeSymbol(reader, table));
+    }
+  }
+  for (; i < count; i++) {
+    reader.refill();
+    out[i] = static_cast<uint8_t>(decodeSymbol(reader, table));
+  }
+}
+
+bool decodeSymbols(const uint8_t * in, size_t size, const DecodeTable & table, uint8_t * out, size_t count) {
+  BitReader reader(in, size);
+  decodeRun(reader, table, out, count);
+  return !reader.overrun();
+}
+
+bool decodeSymbolsCrc32c(const uint8_t * in, size_t size, const DecodeTable & table, uint8_t * out, size_t count,
+                         uint32_t & checksum) {
+  BitReader reader(in, size);
+  uint32_t crc = 0;
+  //Checksum each chunk right after decoding it, while it is still in L1
+  for (size_t done = 0; done < count;) {
+    size_t chunk = std::min(CRC_CHUNK_SIZE, count - done);
+    decodeRun(reader, table, out + done, chunk);
+    crc = crc32c(out + done, chunk, crc);
+    done += chunk;
+  }
+  checksum = crc;
+  return !reader.overrun();
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "huffman.h"
+
+
+//Default primary lookup width: 2^10 entries * 2 bytes = 2KB, small enough for many live tables in L1
+constexpr int DEFAULT_LOOKUP_BITS = 10;
+
+/**
+ * @brief Two-level decode table with packed 16-bit entries.
+ * The primary table is indexed by the next lookupBits bits (fewer if every code is shorter).
+ * A primary entry is code length in bits 0-3 and symbol in bits 4-15. Codes longer than lookupBits
+ * share a primary entry per prefix with length 0 and a subtable number in bits 4-15. The subtables
+ * follow the primary table in entries; each has 2^subtableBits entries indexed by the code's
+ * remaining bits, and those entries store the full code length.
+ * Only built from validated code lengths, so every entry is a real symbol.
+ * */
+struct DecodeTable {
+  std::vector<uint16_t> entries;
+  int lookupBits = 0;    //primary width actually used
+  uint64_t mask = 0;     //primary index mask
+  int subtableBits = 0;  //longest - lookupBits, 0 when there are no long codes
+  int longest = 0;
+  int shortest = 0;      //no symbol takes fewer bits, bounds the symbols a bit range can hold
+
+  /**
+   * @brief bytes of table memory, primary plus subtables
+   * */
+  size_t footprint() const {
+    return entries.size() * sizeof(uint16_t);
+  }
+};
+
+//Bits guaranteed after BitReader::refill(): the 8-byte load path sets bitCount |= 56
+constexpr uint32_t MIN_REFILL_BITS = 56;
+
+/**
+ * @brief LSB-first bit reader with a 64-bit buffer
+ * refill() tops the buffer up to at least MIN_REFILL_BITS bits. While 8 input bytes remain it is one unaligned load;
+ * near the end it switches to a byte loop that shifts in zeros past the end of the input.
+ * Nothing is checked per symbol: overrun() tells afterwards whether more bits were used than the input had.
+ * */
+class BitReader {
+  private:
+    const uint8_t * in;
+    size_t size;
+    size_t pos = 0;
+    uint64_t buffer = 0;
+    uint32_t bitCount = 0;
+
+  public:
+    BitReader(const uint8_t * in, size_t size, uint64_t startBit = 0) : in(in), size(size) {
+      pos = static_cast<size_t>(std::min<uint64_t>(startBit / 8, size));
+      refill();
+      if (startBit / 8 < size) {
+        consume(static_cast<uint32_t>(startBit % 8));
+      }
+    }
+
+    void refill() {
+      static_assert(std::endian::native == std::endian::little, "the 8-byte refill assumes a little-endian target");
+      if (pos + 8 <= size) {
+        uint64_t word;
+        std::memcpy(&word, in + pos, sizeof(word));
+        buffer |= word << bitCount;
+        pos += (63 - bitCount) >> 3;
+        bitCount |= 56;
+      }
+      else {
+        while (bitCount <= 56) {
+          buffer |= static_cast<uint64_t>(pos < size ? in[pos] : 0) << bitCount;
+          pos++;
+          bitCount += 8;
+        }
+      }
+    }
+
+    uint64_t peek() const {
+      return buffer;
+    }
+
+    void consume(uint32_t bits) {
+      buffer >>= bits;
+      bitCount -= bits;
+    }
+
+    /**
+     * @brief read bits (<= 32) that were already refilled
+     * */
+    uint32_t readBits(uint32_t bits) {
+      uint32_t value = static_cast<uint32_t>(buffer & ((uint64_t{1} << bits) - 1));
+      consume(bits);
+      return value;
+    }
+
+    /**
+     * @brief position of the next unread bit from the start of the input
+     * */
+    uint64_t bitPosition() const {
+      return static_cast<uint64_t>(pos) * 8 - bitCount;
+    }
+
+    /**
+     * @brief true if decoding used bits past the end of the input
+     * */
+    bool overrun() const {
+      return bitPosition() > static_cast<uint64_t>(size) * 8;
+    }
+}; //end BitReader Class
+
+/**
+ * @brief decode one symbol, the caller has refilled for at least table.longest bits
+ * */
+inline int decodeSymbol(BitReader & reader, const DecodeTable & table) {
+  uint64_t bits = reader.peek();
+  uint16_t entry = table.entries[bits & table.mask];
+  if ((entry & 0x0F) == 0) [[unlikely]] {
+    //Long code: the remaining bits index this prefix's subtable
+    size_t subtable = (size_t{1} << table.lookupBits) + (static_cast<size_t>(entry >> 4) << table.subtableBits);
+    entry = table.entries[subtable + ((bits >> table.lookupBits) & ((uint64_t{1} << table.subtableBits) - 1))];
+  }
+  reader.consume(entry & 0x0F);
+  return entry >> 4;
+}
+
+/**
+ * @brief validate code lengths and build a decode table with a primary width of lookupBits (1-15)
+ * Rejects lengths above MAX_CODE_LENGTH, over-subscribed sets (Kraft sum > 1), incomplete sets
+ * (Kraft sum < 1) other than a single 1-bit code, and alphabets too big for the 12-bit symbol field.
+ * @return false if the lengths cannot come from a valid Huffman code
+ * */
+bool buildDecodeTable(std::span<const uint8_t> lengths, DecodeTable & table, int lookupBits = DEFAULT_LOOKUP_BITS);
+
+/**
+ * @brief Thread-safe cache of decode tables keyed by code lengths
+ * Blocks compressed from similar data often end up with identical code lengths; they then share one
+ * table instead of each building and keeping its own. When full, an arbitrary entry is dropped; tables
+ * stay alive for as long as a caller holds them.
+ * Every table is built with the cache's primary lookup width, the knob for fitting decoders into L1.
+ * */
+class DecodeTableCache {
+  private:
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const DecodeTable>> tables;
+    size_t capacity;
+    int primaryBits;
+    size_t hitCount = 0;
+    size_t missCount = 0;
+
+  public:
+    explicit DecodeTableCache(size_t capacity = 256, int lookupBits = DEFAULT_LOOKUP_BITS)
+        : capacity(capacity), primaryBits(lookupBits) {}
+
+    /**
+     * @brief return the table for lengths, building it on a miss
+     * @return nullptr if the lengths are invalid
+     * */
+    std::shared_ptr<const DecodeTable> get(std::span<const uint8_t> lengths);
+
+    int lookupBits() const {
+      return primaryBits;
+    }
+
+    size_t hits() {
+      std::lock_guard<std::mutex> lock(mutex);
+      return hitCount;
+    }
+
+    size_t misses() {
+      std::lock_guard<std::mutex> lock(mutex);
+      return missCount;
+    }
+
+    /**
+     * @brief bytes of table memory held by the cache
+     * */
+    size_t footprint();
+}; //end DecodeTableCache Class
+
+/**
+ * @brief decode table for lengths: shared from cache when there is one, otherwise built into local
+ * A cached table has the cache's lookup width, a local one lookupBits. holder keeps a cached table alive
+ * while the caller uses it.
+ * @return the table, nullptr if lengths do not form a valid code
+ * */
+const DecodeTable * acquireDecodeTable(std::span<const uint8_t> lengths, DecodeTableCache * cache, DecodeTable & local,
+                                       std::shared_ptr<const DecodeTable> & holder,
+                                       int lookupBits = DEFAULT_LOOKUP_BITS);
+
+/**
+ * @brief decode count bytes, the hardened fast counterpart of decodeBytes()
+ * Bounds are handled by BitReader padding and one overrun check at the end, not per symbol.
+ * @return false if the stream is shorter than count symbols need
+ * */
+bool decodeSymbols(const uint8_t * in, size_t size, const DecodeTable & table, uint8_t * out, size_t count);
+
+//Output bytes decoded between two CRC updates in decodeSymbolsCrc32c(), small enough to still be in L1
+constexpr size_t CRC_CHUNK_SIZE = 16 * 1024;
+
+/**
+ * @brief decodeSymbols() that also returns the CRC32C of the output
+ * The checksum is taken over each CRC_CHUNK_SIZE chunk as soon as it is decoded instead of in a second pass.
+ * @return false if the stream is shorter than count symbols need
+ * */
+bool decodeSymbolsCrc32c(const uint8_t * in, size_t size, const DecodeTable & table, uint8_t * out, size_t count,
+                         uint32_t & checksum);
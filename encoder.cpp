@@ -0,0 +1,91 @@
+#include "encoder.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+static_assert(std::endian::native == std::endian::little, "the 8-byte flush assumes a little-endian target");
+
+
+/**
+ * Helper doing one unaligned 8-byte store
+ * */
+static inline void store64(uint8_t * out, uint64_t value) {
+  std::memcpy(out, &value, sizeof(value));
+}
+
+void buildEncodeTable(std::span<const HuffmanCode> codes, EncodeTable & table) {
+  table.maxLength = 0;
+  for (int i = 0; i < ALPHABET_SIZE; i++) {
+    table.entries[i] = codes[static_cast<size_t>(i)].code | (static_cast<uint32_t>(codes[static_cast<size_t>(i)].len) << 16);
+    table.maxLength = std::max(table.maxLength, static_cast<int>(codes[static_cast<size_t>(i)].len));
+  }
+}
+
+//Add one symbol to the accumulator, no branches
+#define PUT_SYMBOL(byte)                                                  \
+  do {                                                                    \
+    uint32_t entry = table.entries[(byte)];                               \
+    buffer |= static_cast<uint64_t>(entry & 0xFFFF) << bitCount;          \
+    bitCount += entry >> 16;                                              \
+  } while (0)
+
+//Write the whole accumulator, advance by the complete bytes and keep the 0-7 leftover bits
+#define FLUSH()                                                           \
+  do {                                                                    \
+    store64(pos, buffer);                                                 \
+    pos += bitCount >> 3;                                                 \
+    buffer >>= bitCount & ~7u;                                            \
+    bitCount &= 7;                                                        \
+  } while (0)
+
+size_t encodeSymbols(std::span<const uint8_t> data, const EncodeTable & table, uint8_t * out) {
+  const uint8_t * in = data.data();
+  const size_t size = data.size();
+  uint8_t * pos = out;
+  uint64_t buffer = 0;
+  uint32_t bitCount = 0;
+  size_t i = 0;
+
+  //At most 7 bits stay in the accumulator after a flush, so 4 codes fit when they are <= 14 bits
+  //(7 + 4 * 14 = 63) and 3 codes always fit (7 + 3 * 15 = 52)
+  if (table.maxLength <= 14) {
+    for (; i + 8 <= size; i += 8) {
+      PUT_SYMBOL(in[i]);
+      PUT_SYMBOL(in[i + 1]);
+      PUT_SYMBOL(in[i + 2]);
+      PUT_SYMBOL(in[i + 3]);
+      FLUSH();
+      PUT_SYMBOL(in[i + 4]);
+      PUT_SYMBOL(in[i + 5]);
+      PUT_SYMBOL(in[i + 6]);
+      PUT_SYMBOL(in[i + 7]);
+      FLUSH();
+    }
+  }
+  else {
+    for (; i + 6 <= size; i += 6) {
+      PUT_SYMBOL(in[i]);
+      PUT_SYMBOL(in[i + 1]);
+      PUT_SYMBOL(in[i + 2]);
+      FLUSH();
+      PUT_SYMBOL(in[i + 3]);
+      PUT_SYMBOL(in[i + 4]);
+      PUT_SYMBOL(in[i + 5]);
+      FLUSH();
+    }
+  }
+
+  for (; i < size; i++) {
+    PUT_SYMBOL(in[i]);
+    FLUSH();
+  }
+
+  //Last partial byte
+  store64(pos, buffer);
+  pos += (bitCount + 7) >> 3;
+  return static_cast<size_t>(pos - out);
+}
+
+#undef PUT_SYMBOL
+#undef FLUSH
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "huffman.h"
+
+
+/**
+ * @brief Flat encode table used by the fast encoder.
+ * Every entry fuses one code with its length (code in bits 0-15, length in bits 16-23)
+ * so a symbol costs a single 32-bit load.
+ * */
+struct EncodeTable {
+  uint32_t entries[ALPHABET_SIZE];
+  int maxLength; //longest code in the table, decides how many symbols fit in one flush
+};
+
+/**
+ * @brief pack a code table into an EncodeTable
+ * @params codes (ALPHABET_SIZE entries), table to fill
+ * */
+void buildEncodeTable(std::span<const HuffmanCode> codes, EncodeTable & table);
+
+/**
+ * @brief encode bytes with the fast kernel, output is bit-identical to encodeBytes()
+ * Codes go into a 64-bit accumulator, several symbols per flush, and each flush is one
+ * unaligned 8-byte store, so out needs room for maxEncodedSize(data.size()) bytes.
+ * @return number of bytes written (last byte zero padded)
+ * */
+size_t encodeSymbols(std::span<const uint8_t> data, const EncodeTable & table, uint8_t * out);
@@ -0,0 +1,93 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "container.h"
+#include "decoder.h"
+#include "huffman.h"
+#include "lz.h"
+#include "parallel_decode.h"
+
+
+/**
+ * Fuzz entry point for every decoder that takes untrusted bytes.
+ * The first input byte picks the decoder, the rest is its input:
+ *   0 decompressBuffer, 1 decompressBuffer with a shared table cache, 2 decompressLevel,
+ *   3 decompressBufferParallel, 4/5 decodeBlock (dynamic / static table) behind a 12-byte block header
+ * A decoder may reject anything but must never crash, read out of bounds or report success with the wrong size.
+ * */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size) {
+  if (size == 0) {
+    return 0;
+  }
+  const uint8_t selector = data[0] % 6;
+  const uint8_t * in = data + 1;
+  const size_t inSize = size - 1;
+  static DecodeTableCache cache(16);
+  std::string out;
+
+  switch (selector) {
+    case 0:
+      decompressBuffer(in, inSize, out);
+      break;
+    case 1:
+      decompressBuffer(in, inSize, out, &cache);
+      break;
+    case 2:
+      decompressLevel(in, inSize, out, &cache);
+      break;
+    case 3:
+      decompressBufferParallel(in, inSize, out, 2);
+      break;
+    default: {
+      if (inSize < BLOCK_HEADER_SIZE) {
+        return 0;
+      }
+      ContainerHeader header;
+      header.tableType = selector == 4 ? TableType::Dynamic : TableType::StaticMerchant;
+      header.blockSize = 1 << 16;
+      BlockHeader block = readBlockHeader(in);
+      //Same limits decompressFile checks before calling decodeBlock
+      block.compressedSize = static_cast<uint32_t>(inSize - BLOCK_HEADER_SIZE);
+      if (block.uncompressedSize == 0 || block.uncompressedSize > header.blockSize) {
+        return 0;
+      }
+      BlockStatus status = decodeBlock(block, in + BLOCK_HEADER_SIZE, header, out, &cache);
+      if (status == BlockStatus::Ok && out.size() != block.uncompressedSize) {
+        std::abort();
+      }
+      break;
+    }
+  }
+  return 0;
+}
+
+#ifndef HUFFMAN_LIBFUZZER
+/**
+ * Standalone driver: runs each file given on the command line through the fuzz entry point,
+ * so crashes found by libFuzzer can be replayed without it
+ * */
+int main(int argc, char * argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: fuzz_decode <input files>" << std::endl;
+    return 1;
+  }
+  for (int i = 1; i < argc; i++) {
+    std::ifstream file(argv[i], std::ios::binary);
+    if (!file) {
+      std::cerr << "Error opening " << argv[i] << std::endl;
+      return 1;
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    std::string input = ss.str();
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(input.data()), input.size());
+  }
+  std::cout << "ran " << argc - 1 << " inputs" << std::endl;
+  return 0;
+}
+#endif
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "container.h"
+#include "crc32c.h"
+#include "decoder.h"
+#include "huffman.h"
+#include "lz.h"
+#include "parallel_decode.h"
+
+
+/**
+ * Helper making a random input with one of a few shapes: uniform bytes, a skewed alphabet,
+ * a single repeated byte, or repeated phrases the LZ levels can match
+ * */
+static std::vector<uint8_t> randomInput(std::mt19937_64 & rng) {
+  std::uniform_int_distribution<size_t> sizeDist(0, 1 << 16);
+  std::vector<uint8_t> data(sizeDist(rng));
+  switch (rng() % 4) {
+    case 0:
+      for (uint8_t & byte : data) {
+        byte = static_cast<uint8_t>(rng());
+      }
+      break;
+    case 1: {
+      std::geometric_distribution<int> skew(0.2);
+      for (uint8_t & byte : data) {
+        byte = static_cast<uint8_t>(std::min(skew(rng), 255));
+      }
+      break;
+    }
+    case 2:
+      std::fill(data.begin(), data.end(), static_cast<uint8_t>(rng()));
+      break;
+    default: {
+      std::vector<uint8_t> phrase(1 + rng() % 40);
+      for (uint8_t & byte : phrase) {
+        byte = static_cast<uint8_t>('a' + rng() % 26);
+      }
+      for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (rng() % 50 == 0) ? static_cast<uint8_t>(rng()) : phrase[i % phrase.size()];
+      }
+      break;
+    }
+  }
+  return data;
+}
+
+/**
+ * Helper comparing decoded output with the original bytes
+ * */
+static bool sameBytes(const std::string & out, std::span<const uint8_t> data) {
+  return out.size() == data.size() &&
+         std::equal(data.begin(), data.end(), reinterpret_cast<const uint8_t *>(out.data()));
+}
+
+/**
+ * Helper to fail a property with the seed and iteration needed to reproduce it
+ * */
+static void check(bool condition, const std::string & property, uint64_t seed, int iteration) {
+  if (!condition) {
+    std::ostringstream message;
+    message << property << " failed (seed " << seed << ", iteration " << iteration << ")";
+    throw std::runtime_error(message.str());
+  }
+}
+
+/**
+ * Helper checking one encoded buffer against its properties:
+ * it decodes back to data, a single flipped bit never decodes silently to the wrong bytes
+ * when checked by block CRC, and no proper prefix decodes
+ * */
+static void checkBlock(std::span<const uint8_t> data, const ContainerHeader & header, LzContext & context,
+                       DecodeTableCache & cache, std::mt19937_64 & rng, uint64_t seed, int iteration) {
+  std::vector<uint8_t> frame(maxBlockFrameSize(std::max<size_t>(data.size(), 1)));
+  size_t frameSize = encodeBlock(data, frame.data(), header, context);
+  BlockHeader block = readBlockHeader(frame.data());
+  const uint8_t * payload = frame.data() + BLOCK_HEADER_SIZE;
+  std::string out;
+
+  check(block.compressedSize == frameSize - BLOCK_HEADER_SIZE, "block size field", seed, iteration);
+  check(decodeBlock(block, payload, header, out, &cache) == BlockStatus::Ok &&
+            sameBytes(out, data),
+        "round trip", seed, iteration);
+  check(block.checksum == crc32c(data.data(), data.size()), "block checksum", seed, iteration);
+
+  BlockHeader resized = block;
+  resized.uncompressedSize++;
+  check(decodeBlock(resized, payload, header, out, &cache) != BlockStatus::Ok, "size mismatch detection", seed,
+        iteration);
+
+  if (block.compressedSize == 0) {
+    return;
+  }
+  std::vector<uint8_t> damaged(payload, payload + block.compressedSize);
+  size_t bit = rng() % (damaged.size() * 8);
+  damaged[bit / 8] ^= static_cast<uint8_t>(1u << (bit % 8));
+  BlockStatus status = decodeBlock(block, damaged.data(), header, out, &cache);
+  check(status != BlockStatus::Ok || sameBytes(out, data),
+        "bit flip detection", seed, iteration);
+
+  size_t cut = rng() % block.compressedSize;
+  BlockHeader truncated = block;
+  truncated.compressedSize = static_cast<uint32_t>(cut);
+  check(decodeBlock(truncated, payload, header, out, &cache) != BlockStatus::Ok, "truncation detection", seed,
+        iteration);
+}
+
+/**
+ * Property test over random inputs: every level and table type round trips through the block coder,
+ * the parallel decoder agrees with the serial one, and corruption or truncation is never accepted as valid
+ * usage: roundtrip [iterations] [seed]
+ * */
+int main(int argc, char * argv[]) {
+  int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+  uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : std::random_device{}();
+  std::mt19937_64 rng(seed);
+  LzContext context;
+  DecodeTableCache cache(16);
+
+  try {
+    for (int i = 0; i < iterations; i++) {
+      std::vector<uint8_t> data = randomInput(rng);
+      if (data.empty()) {
+        continue;
+      }
+
+      ContainerHeader header;
+      for (int level = 0; level <= MAX_LEVEL; level++) {
+        header.level = static_cast<uint8_t>(level);
+        checkBlock(data, header, context, cache, rng, seed, i);
+      }
+      header.tableType = TableType::StaticMerchant;
+      header.level = 0;
+      checkBlock(data, header, context, cache, rng, seed, i);
+
+      std::vector<uint8_t> compressed(maxCompressedSize(data.size()));
+      size_t compressedSize = compressBuffer(data, compressed.data(), context.huffman);
+      std::string serial;
+      std::string parallel;
+      check(decompressBuffer(compressed.data(), compressedSize, serial) &&
+                decompressBufferParallel(compressed.data(), compressedSize, parallel, 3) && serial == parallel,
+            "parallel decode", seed, i);
+    }
+  }
+  catch (const std::exception & e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  std::cout << iterations << " iterations passed (seed " << seed << ")" << std::endl;
+  return 0;
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cassert>
+#include <iostream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+
+/**
+ * @brief HeapNode structure that hold frequency, value, pointers to left and right child.
+ * Provide comparision operator (> < =) based on the primary key (frequency) and secondary key (value)
+ * */
+template <typename Comparable>
+struct HeapNode {
+  int frequency; // Primary key
+  Comparable value; // Value and also a secondary key
+  HeapNode* left;   // Pointer to the left child
+  HeapNode* right;  // Pointer to the right child
+
+  //Constructor
+  HeapNode(int f, const Comparable & v) : frequency(f), value(v), left(nullptr), right(nullptr){}
+
+  // Less-than operator for comparing HeapNode objects by key
+  bool operator<(const HeapNode & other) const {
+    if (frequency == other.frequency) {
+      return value < other.value;
+    }
+    return frequency<other.frequency;
+  }
+
+  //Greater-than operator for comparing HeadNode objects by key
+  bool operator>(const HeapNode & other) const {
+    if (frequency == other.frequency) {
+      return value > other.value;
+    }
+    return frequency>other.frequency;
+  }
+
+  // Equal operator for comparing HeapNode objects
+  bool operator==(const HeapNode & other) const {
+    return frequency == other.frequency && value == other.value;
+  }
+
+  // Overload the << operator for printing HeapNode
+  friend std::ostream &operator<<(std::ostream &os, const HeapNode &node) {
+    os << "{" << node.frequency << ":" << node.value << "}";
+    return os;
+  }
+};//end of HeapNode struct
+
+/**
+ * @brief Class that provides Minimum heap data structure
+ * The data structure ensures storing comparable elements with the smallest key as the highest priority
+ * Provide necessary functions to perform storing, and retrieving data
+ * */
+template <typename Comparable>
+class MinHeap {
+  private:
+
+    //Dynamic array to store elements of the heap
+    std::vector<Comparable> heap;
+
+    /**
+     * @brief Private function to move the lower priority key down the tree.
+     * @params int index 
+     * @return nothing
+     * */
+    void percolateDown(int i) {
+      int leftChildIndex = 2 * i + 1;
+      int rightChildIndex = 2 * i + 2;
+      int smallestChildIndex = i;
+
+      if (leftChildIndex < static_cast<int>(heap.size()) && heap[leftChildIndex] < heap[smallestChildIndex]) {
+        smallestChildIndex = leftChildIndex;
+      }
+
+      if (rightChildIndex < static_cast<int>(heap.size()) && heap[rightChildIndex] < heap[smallestChildIndex]) {
+        smallestChildIndex = rightChildIndex;
+      }
+
+      if(smallestChildIndex != i){
+        std::swap(heap[i], heap[smallestChildIndex]);
+        percolateDown(smallestChildIndex);
+      }
+    }
+
+    /**
+     * @brief Private function to move the higher priority key up the tree
+     * @params int index
+     * @return nothing
+     * */
+    void percolateUp(int i) {
+      // Only called by privateInsert with the last index, so a bad index is a bug, not an input error
+      assert(i < static_cast<int>(heap.size()));
+
+      int currIndex = i;
+
+      while (currIndex > 0 && heap[currIndex] < heap[(currIndex - 1)/2]) {
+        std::swap(heap[currIndex], heap[(currIndex - 1)/2]);
+        currIndex = (currIndex - 1)/2;
+      }
+
+    }
+
+    /**
+     * @brief function that build out a heap structure from an array
+     * Helper for constructor when users want to initialize the heap with an array
+     * @params: nothing
+     * @return: nothing
+     * */
+    void buildHeap() {
+      for (int i = static_cast<int>((heap.size()/2 - 1)); i >= 0; i--){
+        percolateDown(i);
+      }
+    }
+
+    /**
+     * @brief private function to insert an element into the heap
+     * @params: const Comparable & node 
+     * @return nothing
+     * */
+    void privateInsert(const Comparable & node) {
+      heap.push_back(node); //Inser the element to the back of the heap array
+      percolateUp(static_cast<int>(heap.size()-1)); //move the inserted element to ensure heap structure
+
+    }
+
+    /**
+     * @brief private function to retrieve and remove an element from the top of the heap (highest priority)
+     * @params nothing
+     * @return Comparable minElement
+     * */
+    Comparable privateDeleteMin() {
+      if (heap.empty()) {
+        throw std::runtime_error("Heap is empty");
+      }
+
+      Comparable minElement = heap[0]; // Copy the element
+      heap[0] = heap[heap.size() - 1]; // Swap it with the last element
+      heap.pop_back(); // Remove the last element
+                       //
+      //If the heap is not empty after removal percolate element at root down
+      if (!heap.empty()) {
+        percolateDown(0);
+      }
+
+      return minElement; //return the copy
+    }
+
+
+    /**
+     * @brief Private function that return the value of the highest priority element
+     * This function does not remove the element from the heap
+     * @params nothing
+     * @return const Comparable & element
+     * */
+    const Comparable & privateMin() const {
+      if (heap.empty()) {
+        throw std::runtime_error("Heap is empty");
+      }
+      return heap[0];
+    }
+
+    /**
+     * @brief Function to display the heap to stdout
+     * */
+    void privateDisplay(){
+      if (heap.empty()) {
+        std::cerr << "Heap is empty" << std::endl;
+        return;
+      }
+      for (auto & element : heap) {
+        std::cout << element << ", ";
+      }
+      std::cout << std::endl;
+    }
+
+
+  public:
+    
+    /**
+     * Constructor that handles both an empty heap or an array of HeapNode
+     * If user initialize with an array, constructor calls buildHeap() function to 
+     * build a heap out of that array.
+     * If nothing is given, an empty heap is created.
+     * */    
+    explicit MinHeap(const std::vector<Comparable> & arr = {}) : heap(arr){
+      if(!heap.empty()) {
+        buildHeap();
+      }
+    };
+
+    /**
+     * @brief public function that check if the heap is empty
+     * @return true/false
+     * */
+    bool empty() {
+      return heap.empty();
+    }
+
+    /** 
+     * @brief public funtion that return current size of the heap
+     * @return int size
+     * */
+    int size() {
+      return static_cast<int>(this->heap.size());
+    }
+    /**
+     * @brief public function that insert an element to the heap
+     * @params const Comparable & node 
+     * @return nothing
+     * */
+    void insert(const Comparable & node) {
+      privateInsert(node);
+    } 
+
+    /**
+     * @brief public funtion that delete the highest priority element from the heap and return that element
+     * @params nothing
+     * @return Comparable element 
+     * */
+    Comparable deleteMin() {
+      return privateDeleteMin();
+    }
+
+    /**
+     * @brief public function that return the value of the highest priority element
+     * This function does not remove the element from the heap
+     * @params nothing
+     * @return const Comparable & element
+     * */
+    const Comparable & min() const {
+      return privateMin();
+    }
+
+    /**
+     * @brief public funtion to display the heap to stdout 
+     * */
+    void display() {
+      this->privateDisplay();
+    }
+
+    /**
+     * @brief public function that remove every element but keep the allocated storage
+     * Lets a caller reuse one heap across many builds without reallocating
+     * */
+    void clear() {
+      heap.clear();
+    }
+
+    /**
+     * @brief public function that reserve storage for n elements up front
+     * @params size_t n
+     * */
+    void reserve(size_t n) {
+      heap.reserve(n);
+    }
+    
+  }; //end MinHeap Class
@@ -0,0 +1,319 @@
+#include "huffman.h"
+
+#include <algorithm>
+
+#include "crc32c.h"
+#include "decoder.h"
+#include "encoder.h"
+
+
+/**
+ * Helper to walk the tree and record the depth of every leaf
+ * params pointer to a node, depth of that node, lengths array to fill, deepest leaf seen so far
+ * */
+static void assignLengths(const HeapNode<int> * node, int depth, std::span<uint8_t> lengths, int & deepest) {
+  //reach a leaf
+  if (node->left == nullptr && node->right == nullptr) {
+    lengths[static_cast<size_t>(node->value)] = static_cast<uint8_t>(std::min(depth, 255));
+    deepest = std::max(deepest, depth);
+    return;
+  }
+
+  if (node->left != nullptr) {
+    assignLengths(node->left, depth + 1, lengths, deepest);
+  }
+
+  if (node->right != nullptr) {
+    assignLengths(node->right, depth + 1, lengths, deepest);
+  }
+}
+
+void countFrequency(std::span<const uint8_t> data, std::span<int> frequency) {
+  std::fill(frequency.begin(), frequency.end(), 0);
+  for (uint8_t byte : data) {
+    frequency[byte]++;
+  }
+}
+
+void buildCodeLengths(std::span<const int> frequency, std::span<uint8_t> lengths, HuffmanScratch & scratch,
+                      int maxLength) {
+  std::span<const int> current = frequency;
+
+  while (true) {
+    std::fill(lengths.begin(), lengths.end(), 0);
+    scratch.heap.clear();
+    scratch.pool.clear();
+    //Every merge stores 2 nodes, so 2 * symbols is enough and the pool never reallocates under the tree
+    scratch.pool.reserve(2 * current.size());
+
+    int symbols = 0;
+    int lastSymbol = 0;
+    for (size_t i = 0; i < current.size(); i++) {
+      if (current[i] > 0) {
+        scratch.heap.insert(HeapNode<int>(current[i], static_cast<int>(i)));
+        symbols++;
+        lastSymbol = static_cast<int>(i);
+      }
+    }
+
+    if (symbols == 0) {
+      return;
+    }
+    //A lone symbol still needs one bit so the decoder can count it
+    if (symbols == 1) {
+      lengths[static_cast<size_t>(lastSymbol)] = 1;
+      return;
+    }
+
+    //Same merge as the prefix-free tree in main(), internal nodes get values above every symbol
+    int nextValue = static_cast<int>(current.size());
+    while (scratch.heap.size() > 1) {
+      scratch.pool.push_back(scratch.heap.deleteMin());
+      HeapNode<int> * left = &scratch.pool.back();
+      scratch.pool.push_back(scratch.heap.deleteMin());
+      HeapNode<int> * right = &scratch.pool.back();
+
+      HeapNode<int> parent(left->frequency + right->frequency, nextValue++);
+      parent.left = left;
+      parent.right = right;
+      scratch.heap.insert(parent);
+    }
+    HeapNode<int> root = scratch.heap.deleteMin();
+
+    int deepest = 0;
+    assignLengths(&root, 0, lengths, deepest);
+    if (deepest <= maxLength) {
+      return;
+    }
+
+    //Tree too deep: flatten the distribution and build again.
+    //Halving keeps the order of the counts, every round gets closer to a balanced tree.
+    if (current.data() != scratch.scaled.data()) {
+      scratch.scaled.assign(current.begin(), current.end());
+    }
+    for (int & count : scratch.scaled) {
+      if (count > 0) {
+        count = (count >> 1) | 1;
+      }
+    }
+    current = scratch.scaled;
+  }
+}
+
+void buildCanonicalCodes(std::span<const uint8_t> lengths, std::span<HuffmanCode> codes) {
+  uint32_t lengthCount[MAX_CODE_LENGTH + 1] = {0};
+  for (uint8_t len : lengths) {
+    lengthCount[len]++;
+  }
+  lengthCount[0] = 0;
+
+  //First code of each length, as in RFC 1951 section 3.2.2
+  uint32_t nextCode[MAX_CODE_LENGTH + 1] = {0};
+  uint32_t code = 0;
+  for (int bits = 1; bits <= MAX_CODE_LENGTH; bits++) {
+    code = (code + lengthCount[bits - 1]) << 1;
+    nextCode[bits] = code;
+  }
+
+  for (size_t symbol = 0; symbol < lengths.size(); symbol++) {
+    int len = lengths[symbol];
+    if (len == 0) {
+      codes[symbol] = HuffmanCode{0, 0};
+    }
+    else {
+      codes[symbol] = HuffmanCode{reverseBits(nextCode[len]++, len), static_cast<uint8_t>(len)};
+    }
+  }
+}
+
+size_t writeVarint(uint64_t value, uint8_t * out) {
+  size_t pos = 0;
+  while (value >= 0x80) {
+    out[pos++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  out[pos++] = static_cast<uint8_t>(value);
+  return pos;
+}
+
+size_t readVarint(const uint8_t * in, size_t size, uint64_t & value) {
+  value = 0;
+  for (size_t pos = 0; pos < size && pos < 10; pos++) {
+    value |= static_cast<uint64_t>(in[pos] & 0x7F) << (7 * pos);
+    if ((in[pos] & 0x80) == 0) {
+      return pos + 1;
+    }
+  }
+  return 0;
+}
+
+size_t writeCodeLengths(std::span<const uint8_t> lengths, uint8_t * out) {
+  size_t count = lengths.size();
+  while (count > 0 && lengths[count - 1] == 0) {
+    count--;
+  }
+
+  size_t pos = writeVarint(count, out);
+  for (size_t i = 0; i < count; i += 2) {
+    uint8_t high = (i + 1 < count) ? lengths[i + 1] : 0;
+    out[pos++] = static_cast<uint8_t>(lengths[i] | (high << 4));
+  }
+  return pos;
+}
+
+size_t readCodeLengths(const uint8_t * in, size_t size, std::span<uint8_t> lengths) {
+  uint64_t count = 0;
+  size_t pos = readVarint(in, size, count);
+  if (pos == 0 || count > lengths.size() || (count + 1) / 2 > size - pos) {
+    return 0;
+  }
+
+  std::fill(lengths.begin(), lengths.end(), 0);
+  for (size_t i = 0; i < count; i += 2) {
+    lengths[i] = in[pos] & 0x0F;
+    if (i + 1 < count) {
+      lengths[i + 1] = in[pos] >> 4;
+    }
+    pos++;
+  }
+  return pos;
+}
+
+size_t encodeBytes(std::span<const uint8_t> data, std::span<const HuffmanCode> codes, uint8_t * out) {
+  uint64_t buffer = 0;
+  int bitCount = 0;
+  size_t pos = 0;
+
+  for (uint8_t byte : data) {
+    const HuffmanCode & code = codes[byte];
+    buffer |= static_cast<uint64_t>(code.code) << bitCount;
+    bitCount += code.len;
+    while (bitCount >= 8) {
+      out[pos++] = static_cast<uint8_t>(buffer);
+      buffer >>= 8;
+      bitCount -= 8;
+    }
+  }
+  if (bitCount > 0) {
+    out[pos++] = static_cast<uint8_t>(buffer);
+  }
+  return pos;
+}
+
+bool decodeBytes(const uint8_t * in, size_t size, std::span<const uint8_t> lengths, uint8_t * out, size_t count) {
+  //Symbols sorted by (length, symbol) plus how many codes each length has, the layout used by puff
+  int lengthCount[MAX_CODE_LENGTH + 1] = {0};
+  for (uint8_t len : lengths) {
+    if (len > MAX_CODE_LENGTH) {
+      return false;
+    }
+    lengthCount[len]++;
+  }
+  int offset[MAX_CODE_LENGTH + 2] = {0};
+  for (int len = 1; len <= MAX_CODE_LENGTH; len++) {
+    offset[len + 1] = offset[len] + lengthCount[len];
+  }
+  std::vector<int> sorted(static_cast<size_t>(offset[MAX_CODE_LENGTH + 1]));
+  for (size_t symbol = 0; symbol < lengths.size(); symbol++) {
+    if (lengths[symbol] != 0) {
+      sorted[static_cast<size_t>(offset[lengths[symbol]]++)] = static_cast<int>(symbol);
+    }
+  }
+
+  size_t bitPos = 0;
+  const size_t bitLimit = size * 8;
+  for (size_t i = 0; i < count; i++) {
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    bool found = false;
+    for (int len = 1; len <= MAX_CODE_LENGTH; len++) {
+      if (bitPos >= bitLimit) {
+        return false;
+      }
+      code |= (in[bitPos >> 3] >> (bitPos & 7)) & 1;
+      bitPos++;
+      int lenCount = lengthCount[len];
+      if (code - lenCount < first) {
+        out[i] = static_cast<uint8_t>(sorted[static_cast<size_t>(index + (code - first))]);
+        found = true;
+        break;
+      }
+      index += lenCount;
+      first += lenCount;
+      first <<= 1;
+      code <<= 1;
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t compressBuffer(std::span<const uint8_t> data, uint8_t * out, HuffmanContext & context,
+                      uint32_t * checksum) {
+  size_t pos = writeVarint(data.size(), out);
+  if (checksum != nullptr) {
+    *checksum = 0;
+  }
+  if (data.empty()) {
+    return pos;
+  }
+
+  if (checksum != nullptr) {
+    *checksum = countFrequencyCrc32c(data, context.frequency);
+  }
+  else {
+    countFrequency(data, context.frequency);
+  }
+  buildCodeLengths(context.frequency, context.lengths, context.scratch);
+  buildCanonicalCodes(context.lengths, context.codes);
+
+  EncodeTable table;
+  buildEncodeTable(context.codes, table);
+
+  pos += writeCodeLengths(context.lengths, out + pos);
+  pos += encodeSymbols(data, table, out + pos);
+  return pos;
+}
+
+bool decompressBuffer(const uint8_t * in, size_t size, std::string & out, DecodeTableCache * cache,
+                      uint32_t * checksum, uint64_t expectedSize) {
+  uint64_t rawSize = 0;
+  size_t pos = readVarint(in, size, rawSize);
+  if (pos == 0 || (expectedSize != ANY_SIZE && rawSize != expectedSize)) {
+    return false;
+  }
+  out.clear();
+  if (checksum != nullptr) {
+    *checksum = 0;
+  }
+  if (rawSize == 0) {
+    return true;
+  }
+
+  uint8_t lengths[ALPHABET_SIZE];
+  size_t headerSize = readCodeLengths(in + pos, size - pos, lengths);
+  if (headerSize == 0) {
+    return false;
+  }
+  pos += headerSize;
+
+  //Every symbol takes at least one bit, anything claiming more is corrupt
+  if (rawSize > (size - pos) * 8) {
+    return false;
+  }
+  DecodeTable local;
+  std::shared_ptr<const DecodeTable> cached;
+  const DecodeTable * table = acquireDecodeTable(lengths, cache, local, cached);
+  if (table == nullptr) {
+    return false;
+  }
+  out.resize(rawSize);
+  uint8_t * dest = reinterpret_cast<uint8_t *>(out.data());
+  if (checksum != nullptr) {
+    return decodeSymbolsCrc32c(in + pos, size - pos, *table, dest, rawSize, *checksum);
+  }
+  return decodeSymbols(in + pos, size - pos, *table, dest, rawSize);
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "heap.h"
+
+
+class DecodeTableCache;
+
+//Longest code the library will emit, same limit as deflate
+constexpr int MAX_CODE_LENGTH = 15;
+
+//Number of symbols in a plain byte alphabet
+constexpr int ALPHABET_SIZE = 256;
+
+/**
+ * @brief One entry of a flat code table.
+ * code holds the canonical code bit-reversed, so it can be OR-ed straight into an LSB-first bit buffer.
+ * len == 0 means the symbol does not occur.
+ * */
+struct HuffmanCode {
+  uint32_t code;
+  uint8_t len;
+};
+
+/**
+ * @brief reverse the low len bits of code
+ * Canonical codes are defined MSB-first but the bit writers are LSB-first.
+ * */
+constexpr uint32_t reverseBits(uint32_t code, int len) {
+  uint32_t reversed = 0;
+  for (int i = 0; i < len; i++) {
+    reversed = (reversed << 1) | (code & 1);
+    code >>= 1;
+  }
+  return reversed;
+}
+
+/**
+ * @brief Scratch state reused by every table build.
+ * Holds the heap and the pool of tree nodes so building a codebook does no allocation after the first call.
+ * */
+struct HuffmanScratch {
+  MinHeap<HeapNode<int>> heap;
+  std::vector<HeapNode<int>> pool; //tree nodes, reserved up front so child pointers stay valid
+  std::vector<int> scaled;         //frequencies flattened when the tree is too deep
+};
+
+/**
+ * @brief Reusable context for compressing one buffer after another.
+ * Everything a single compression needs lives here, so a caller that keeps one context alive
+ * pays for the allocations once instead of once per message.
+ * */
+struct HuffmanContext {
+  std::vector<int> frequency = std::vector<int>(ALPHABET_SIZE, 0);
+  std::vector<uint8_t> lengths = std::vector<uint8_t>(ALPHABET_SIZE, 0);
+  std::vector<HuffmanCode> codes = std::vector<HuffmanCode>(ALPHABET_SIZE, HuffmanCode{0, 0});
+  HuffmanScratch scratch;
+};
+
+/**
+ * @brief count how many times each byte occurs, frequency is reset first
+ * @params data, frequency (size ALPHABET_SIZE)
+ * */
+void countFrequency(std::span<const uint8_t> data, std::span<int> frequency);
+
+/**
+ * @brief compute Huffman code lengths from a frequency table, limited to maxLength bits
+ * Symbols with frequency 0 get length 0. A lone symbol gets length 1.
+ * @params frequency, lengths (same size as frequency), scratch, maxLength
+ * */
+void buildCodeLengths(std::span<const int> frequency, std::span<uint8_t> lengths, HuffmanScratch & scratch,
+                      int maxLength = MAX_CODE_LENGTH);
+
+/**
+ * @brief assign canonical codes from code lengths (deflate ordering: shorter codes first, ties by symbol)
+ * @params lengths, codes (same size as lengths)
+ * */
+void buildCanonicalCodes(std::span<const uint8_t> lengths, std::span<HuffmanCode> codes);
+
+/**
+ * @brief serialize code lengths as a varint count followed by packed 4-bit lengths
+ * Trailing zero lengths are not stored.
+ * @return number of bytes written
+ * */
+size_t writeCodeLengths(std::span<const uint8_t> lengths, uint8_t * out);
+
+/**
+ * @brief read code lengths written by writeCodeLengths, missing trailing lengths are set to 0
+ * @return number of bytes consumed, 0 if the header is malformed
+ * */
+size_t readCodeLengths(const uint8_t * in, size_t size, std::span<uint8_t> lengths);
+
+/**
+ * @brief LEB128 helpers used for sizes in headers
+ * readVarint returns the number of bytes consumed, 0 if the input ends early or overflows
+ * */
+size_t writeVarint(uint64_t value, uint8_t * out);
+size_t readVarint(const uint8_t * in, size_t size, uint64_t & value);
+
+/**
+ * @brief encode bytes with a code table into out, LSB-first
+ * Simple one-symbol-at-a-time reference, the hot paths use encodeSymbols() from encoder.h.
+ * out needs room for maxEncodedSize(data.size()) bytes.
+ * @return number of bytes written (last byte zero padded)
+ * */
+size_t encodeBytes(std::span<const uint8_t> data, std::span<const HuffmanCode> codes, uint8_t * out);
+
+/**
+ * @brief decode count symbols from in using canonical codes rebuilt from lengths
+ * Bit-at-a-time reference, the hot paths use decodeSymbols() from decoder.h.
+ * @return true on success, false if the stream is truncated or does not match the table
+ * */
+bool decodeBytes(const uint8_t * in, size_t size, std::span<const uint8_t> lengths, uint8_t * out, size_t count);
+
+//expectedSize argument of the decompress functions that accepts whatever size the frame declares
+constexpr uint64_t ANY_SIZE = UINT64_MAX;
+
+/**
+ * @brief worst case size of encodeBytes output for rawSize input bytes, including slack for word stores
+ * */
+constexpr size_t maxEncodedSize(size_t rawSize) {
+  return (rawSize * MAX_CODE_LENGTH + 7) / 8 + 8;
+}
+
+/**
+ * @brief worst case size of compressBuffer output
+ * */
+constexpr size_t maxCompressedSize(size_t rawSize) {
+  return 10 + 2 + ALPHABET_SIZE / 2 + maxEncodedSize(rawSize);
+}
+
+/**
+ * @brief compress a buffer as: varint raw size, code lengths, encoded payload
+ * With checksum set, the CRC32C of data comes from the same pass as the histogram (countFrequencyCrc32c()).
+ * @params data, out (room for maxCompressedSize(data.size())), context reused between calls, checksum
+ * @return number of bytes written
+ * */
+size_t compressBuffer(std::span<const uint8_t> data, uint8_t * out, HuffmanContext & context,
+                      uint32_t * checksum = nullptr);
+
+/**
+ * @brief decompress a buffer written by compressBuffer, the result replaces the contents of out
+ * With a cache, blocks whose code lengths were seen before reuse the same decode table.
+ * With checksum set, the CRC32C of the output is computed chunk by chunk while it is decoded.
+ * A frame whose raw size is not expectedSize is rejected before any output is allocated.
+ * @return true on success, false if the input is malformed
+ * */
+bool decompressBuffer(const uint8_t * in, size_t size, std::string & out, DecodeTableCache * cache = nullptr,
+                      uint32_t * checksum = nullptr, uint64_t expectedSize = ANY_SIZE);
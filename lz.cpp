@@ -0,0 +1,395 @@
+#include "lz.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#include "crc32c.h"
+#include "decoder.h"
+#include "parallel_decode.h"
+
+
+//Method byte at the start of every compressLevel() frame
+constexpr uint8_t METHOD_HUFFMAN = 0;
+constexpr uint8_t METHOD_LZ = 1;
+
+constexpr int HASH_BITS = 15;
+
+//Token layout: literal byte, or MATCH_FLAG | length << 16 | distance
+constexpr uint32_t MATCH_FLAG = 1u << 31;
+
+/**
+ * @brief Match search effort for one level
+ * */
+struct LevelParams {
+  int chainDepth; //positions tried per search
+  int niceLength; //stop searching once a match is this long
+  bool lazy;      //check whether the next position has a longer match before taking one
+};
+
+constexpr LevelParams LEVEL_PARAMS[MAX_LEVEL + 1] = {
+    {0, 0, false},
+    {4, 32, false},
+    {32, 128, true},
+    {256, LZ_MAX_MATCH, true},
+};
+
+//Length codes 257..285 of RFC 1951, stored here as symbols 256..284
+constexpr int LENGTH_BASE[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr int LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+constexpr int DISTANCE_BASE[30] = {1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                   193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr int DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+/**
+ * Helper building the match length -> length code lookup at compile time
+ * */
+constexpr std::array<uint8_t, LZ_MAX_MATCH + 1> makeLengthCodes() {
+  std::array<uint8_t, LZ_MAX_MATCH + 1> codes{};
+  for (int code = 0; code < 29; code++) {
+    int end = code + 1 < 29 ? LENGTH_BASE[code + 1] : LZ_MAX_MATCH + 1;
+    for (int len = LENGTH_BASE[code]; len < end; len++) {
+      codes[static_cast<size_t>(len)] = static_cast<uint8_t>(code);
+    }
+  }
+  //258 has its own code even though 227 + 31 would reach it
+  codes[LZ_MAX_MATCH] = 28;
+  return codes;
+}
+
+constexpr std::array<uint8_t, LZ_MAX_MATCH + 1> LENGTH_CODE = makeLengthCodes();
+
+/**
+ * Helper mapping a distance 1..32768 to its distance code: two codes per power of two above 4
+ * */
+static inline int distanceCode(int distance) {
+  uint32_t x = static_cast<uint32_t>(distance - 1);
+  if (x < 4) {
+    return static_cast<int>(x);
+  }
+  int topBit = std::bit_width(x) - 1;
+  return 2 * topBit + static_cast<int>((x >> (topBit - 1)) & 1);
+}
+
+/**
+ * Helper hashing the 3 bytes at p
+ * */
+static inline uint32_t hash3(const uint8_t * p) {
+  uint32_t value = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16);
+  return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/**
+ * @brief LSB-first bit writer that flushes with 8-byte stores, same scheme as encodeSymbols()
+ * A whole token (at most 48 bits) is put between flushes.
+ * */
+class BitWriter {
+  private:
+    uint8_t * pos;
+    uint64_t buffer = 0;
+    uint32_t bitCount = 0;
+
+  public:
+    explicit BitWriter(uint8_t * out) : pos(out) {}
+
+    void put(uint32_t bits, uint32_t count) {
+      buffer |= static_cast<uint64_t>(bits) << bitCount;
+      bitCount += count;
+    }
+
+    void flush() {
+      std::memcpy(pos, &buffer, sizeof(buffer));
+      pos += bitCount >> 3;
+      buffer >>= bitCount & ~7u;
+      bitCount &= 7;
+    }
+
+    /**
+     * @brief write the last partial byte, return the end of the output
+     * */
+    uint8_t * finish() {
+      std::memcpy(pos, &buffer, sizeof(buffer));
+      return pos + ((bitCount + 7) >> 3);
+    }
+}; //end BitWriter Class
+
+/**
+ * Helper to find the longest match for position pos by walking its hash chain
+ * return match length (0 if below LZ_MIN_MATCH), distance through bestDistance
+ * */
+static int longestMatch(std::span<const uint8_t> data, int pos, const LevelParams & params, const LzContext & context,
+                        int & bestDistance) {
+  const int size = static_cast<int>(data.size());
+  const int maxLength = std::min(LZ_MAX_MATCH, size - pos);
+  if (maxLength < LZ_MIN_MATCH) {
+    return 0;
+  }
+
+  const uint8_t * current = data.data() + pos;
+  int bestLength = LZ_MIN_MATCH - 1;
+  int candidate = context.head[hash3(current)];
+  for (int chain = 0; chain < params.chainDepth && candidate >= 0 && pos - candidate <= LZ_WINDOW_SIZE; chain++) {
+    const uint8_t * match = data.data() + candidate;
+    //Cheap reject: a longer match must agree at the byte that would extend the best one
+    if (match[bestLength] == current[bestLength] && match[0] == current[0]) {
+      int length = 0;
+      while (length < maxLength && match[length] == current[length]) {
+        length++;
+      }
+      if (length > bestLength) {
+        bestLength = length;
+        bestDistance = pos - candidate;
+        if (length >= params.niceLength || length == maxLength) {
+          break;
+        }
+      }
+    }
+    int next = context.prev[static_cast<size_t>(candidate & (LZ_WINDOW_SIZE - 1))];
+    if (next >= candidate) {
+      break; //slot was reused by a newer position, the chain ends here
+    }
+    candidate = next;
+  }
+  return bestLength >= LZ_MIN_MATCH ? bestLength : 0;
+}
+
+/**
+ * Helper inserting position pos into the hash chains
+ * */
+static inline void insertPosition(std::span<const uint8_t> data, int pos, LzContext & context) {
+  if (pos + LZ_MIN_MATCH > static_cast<int>(data.size())) {
+    return;
+  }
+  uint32_t hash = hash3(data.data() + pos);
+  context.prev[static_cast<size_t>(pos & (LZ_WINDOW_SIZE - 1))] = context.head[hash];
+  context.head[hash] = pos;
+}
+
+/**
+ * Helper turning data into literal and match tokens, counting symbol frequencies on the way
+ * */
+static void findMatches(std::span<const uint8_t> data, const LevelParams & params, LzContext & context) {
+  context.head.assign(size_t{1} << HASH_BITS, -1);
+  context.prev.assign(LZ_WINDOW_SIZE, -1);
+  context.tokens.clear();
+  context.litlenFrequency.assign(LITLEN_ALPHABET_SIZE, 0);
+  context.distanceFrequency.assign(DISTANCE_ALPHABET_SIZE, 0);
+
+  const int size = static_cast<int>(data.size());
+  int pos = 0;
+  while (pos < size) {
+    int distance = 0;
+    int length = longestMatch(data, pos, params, context, distance);
+
+    if (length > 0 && params.lazy && length < params.niceLength && pos + 1 < size) {
+      //Take a literal instead if the next position starts a longer match
+      insertPosition(data, pos, context);
+      int nextDistance = 0;
+      int nextLength = longestMatch(data, pos + 1, params, context, nextDistance);
+      if (nextLength > length) {
+        context.tokens.push_back(data[static_cast<size_t>(pos)]);
+        context.litlenFrequency[data[static_cast<size_t>(pos)]]++;
+        pos++;
+        length = nextLength;
+        distance = nextDistance;
+      }
+      else {
+        //pos is already in the chains
+        context.tokens.push_back(MATCH_FLAG | (static_cast<uint32_t>(length) << 16) | static_cast<uint32_t>(distance));
+        context.litlenFrequency[256 + LENGTH_CODE[static_cast<size_t>(length)]]++;
+        context.distanceFrequency[distanceCode(distance)]++;
+        for (int i = 1; i < length; i++) {
+          insertPosition(data, pos + i, context);
+        }
+        pos += length;
+        continue;
+      }
+    }
+
+    if (length > 0) {
+      context.tokens.push_back(MATCH_FLAG | (static_cast<uint32_t>(length) << 16) | static_cast<uint32_t>(distance));
+      context.litlenFrequency[256 + LENGTH_CODE[static_cast<size_t>(length)]]++;
+      context.distanceFrequency[distanceCode(distance)]++;
+      for (int i = 0; i < length; i++) {
+        insertPosition(data, pos + i, context);
+      }
+      pos += length;
+    }
+    else {
+      context.tokens.push_back(data[static_cast<size_t>(pos)]);
+      context.litlenFrequency[data[static_cast<size_t>(pos)]]++;
+      insertPosition(data, pos, context);
+      pos++;
+    }
+  }
+}
+
+size_t compressLevel(std::span<const uint8_t> data, uint8_t * out, int level, LzContext & context,
+                     uint32_t * checksum) {
+  level = std::clamp(level, 0, MAX_LEVEL);
+  if (level == 0) {
+    out[0] = METHOD_HUFFMAN;
+    return 1 + compressBuffer(data, out + 1, context.huffman, checksum);
+  }
+  //The match finder dominates here, a separate checksum pass is noise next to it
+  if (checksum != nullptr) {
+    *checksum = crc32c(data.data(), data.size());
+  }
+
+  out[0] = METHOD_LZ;
+  size_t pos = 1 + writeVarint(data.size(), out + 1);
+  if (data.empty()) {
+    return pos;
+  }
+
+  findMatches(data, LEVEL_PARAMS[level], context);
+  //The decoder needs a valid distance table even when nothing matched
+  if (std::all_of(context.distanceFrequency.begin(), context.distanceFrequency.end(), [](int f) { return f == 0; })) {
+    context.distanceFrequency[0] = 1;
+  }
+
+  context.litlenLengths.resize(LITLEN_ALPHABET_SIZE);
+  context.distanceLengths.resize(DISTANCE_ALPHABET_SIZE);
+  context.litlenCodes.resize(LITLEN_ALPHABET_SIZE);
+  context.distanceCodes.resize(DISTANCE_ALPHABET_SIZE);
+  buildCodeLengths(context.litlenFrequency, context.litlenLengths, context.huffman.scratch);
+  buildCodeLengths(context.distanceFrequency, context.distanceLengths, context.huffman.scratch);
+  buildCanonicalCodes(context.litlenLengths, context.litlenCodes);
+  buildCanonicalCodes(context.distanceLengths, context.distanceCodes);
+  pos += writeCodeLengths(context.litlenLengths, out + pos);
+  pos += writeCodeLengths(context.distanceLengths, out + pos);
+
+  BitWriter writer(out + pos);
+  for (uint32_t token : context.tokens) {
+    if ((token & MATCH_FLAG) == 0) {
+      const HuffmanCode & code = context.litlenCodes[token];
+      writer.put(code.code, code.len);
+    }
+    else {
+      int length = static_cast<int>((token >> 16) & 0x1FF);
+      int distance = static_cast<int>(token & 0xFFFF);
+      int lengthCode = LENGTH_CODE[static_cast<size_t>(length)];
+      int distCode = distanceCode(distance);
+      const HuffmanCode & litlen = context.litlenCodes[static_cast<size_t>(256 + lengthCode)];
+      const HuffmanCode & dist = context.distanceCodes[static_cast<size_t>(distCode)];
+      writer.put(litlen.code, litlen.len);
+      writer.put(static_cast<uint32_t>(length - LENGTH_BASE[lengthCode]), static_cast<uint32_t>(LENGTH_EXTRA[lengthCode]));
+      writer.put(dist.code, dist.len);
+      writer.put(static_cast<uint32_t>(distance - DISTANCE_BASE[distCode]), static_cast<uint32_t>(DISTANCE_EXTRA[distCode]));
+    }
+    writer.flush();
+  }
+  return static_cast<size_t>(writer.finish() - out);
+}
+
+/**
+ * Helper decoding the LZ token stream of a METHOD_LZ frame
+ * */
+static bool decompressLz(const uint8_t * in, size_t size, std::string & out, DecodeTableCache * cache,
+                         uint64_t expectedSize) {
+  uint64_t rawSize = 0;
+  size_t pos = readVarint(in, size, rawSize);
+  if (pos == 0 || (expectedSize != ANY_SIZE && rawSize != expectedSize)) {
+    return false;
+  }
+  out.clear();
+  if (rawSize == 0) {
+    return true;
+  }
+
+  uint8_t litlenLengths[LITLEN_ALPHABET_SIZE];
+  uint8_t distanceLengths[DISTANCE_ALPHABET_SIZE];
+  size_t headerSize = readCodeLengths(in + pos, size - pos, litlenLengths);
+  if (headerSize == 0) {
+    return false;
+  }
+  pos += headerSize;
+  headerSize = readCodeLengths(in + pos, size - pos, distanceLengths);
+  if (headerSize == 0) {
+    return false;
+  }
+  pos += headerSize;
+
+  //A match expands to at most LZ_MAX_MATCH bytes per bit of input, anything beyond is corrupt
+  if (rawSize > (size - pos) * 8 * LZ_MAX_MATCH) {
+    return false;
+  }
+  DecodeTable litlenLocal;
+  DecodeTable distanceLocal;
+  std::shared_ptr<const DecodeTable> litlenCached;
+  std::shared_ptr<const DecodeTable> distanceCached;
+  const DecodeTable * litlenTable = acquireDecodeTable(litlenLengths, cache, litlenLocal, litlenCached);
+  const DecodeTable * distanceTable = acquireDecodeTable(distanceLengths, cache, distanceLocal, distanceCached);
+  if (litlenTable == nullptr || distanceTable == nullptr) {
+    return false;
+  }
+
+  out.resize(rawSize);
+  uint8_t * output = reinterpret_cast<uint8_t *>(out.data());
+  size_t produced = 0;
+  BitReader reader(in + pos, size - pos);
+
+  while (produced < rawSize) {
+    //One refill covers a whole token: 15 + 5 + 15 + 13 bits
+    reader.refill();
+    int symbol = decodeSymbol(reader, *litlenTable);
+    if (symbol < 256) {
+      output[produced++] = static_cast<uint8_t>(symbol);
+      continue;
+    }
+
+    int lengthCode = symbol - 256;
+    int length = LENGTH_BASE[lengthCode] + static_cast<int>(reader.readBits(static_cast<uint32_t>(LENGTH_EXTRA[lengthCode])));
+    int distCode = decodeSymbol(reader, *distanceTable);
+    if (distCode >= DISTANCE_ALPHABET_SIZE) {
+      return false;
+    }
+    size_t distance = static_cast<size_t>(DISTANCE_BASE[distCode]) +
+                      reader.readBits(static_cast<uint32_t>(DISTANCE_EXTRA[distCode]));
+    if (distance > produced || static_cast<size_t>(length) > rawSize - produced) {
+      return false;
+    }
+
+    //Byte copy so overlapping matches (distance < length) repeat the pattern
+    const uint8_t * source = output + produced - distance;
+    for (int i = 0; i < length; i++) {
+      output[produced + static_cast<size_t>(i)] = source[i];
+    }
+    produced += static_cast<size_t>(length);
+  }
+
+  return !reader.overrun();
+}
+
+bool decompressLevel(const uint8_t * in, size_t size, std::string & out, DecodeTableCache * cache,
+                     uint32_t * checksum, int threads, uint64_t expectedSize) {
+  if (size == 0) {
+    return false;
+  }
+  if (in[0] == METHOD_HUFFMAN && threads != 1 && size - 1 >= PARALLEL_DECODE_MIN_SIZE) {
+    //The parallel stitch has no natural chunk boundary to fold the checksum into, take it afterwards
+    if (!decompressBufferParallel(in + 1, size - 1, out, threads, cache, expectedSize)) {
+      return false;
+    }
+    if (checksum != nullptr) {
+      *checksum = crc32c(reinterpret_cast<const uint8_t *>(out.data()), out.size());
+    }
+    return true;
+  }
+  if (in[0] == METHOD_HUFFMAN) {
+    return decompressBuffer(in + 1, size - 1, out, cache, checksum, expectedSize);
+  }
+  if (in[0] == METHOD_LZ) {
+    if (!decompressLz(in + 1, size - 1, out, cache, expectedSize)) {
+      return false;
+    }
+    if (checksum != nullptr) {
+      *checksum = crc32c(reinterpret_cast<const uint8_t *>(out.data()), out.size());
+    }
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "huffman.h"
+
+
+//Compression levels: 0 is Huffman only, 1-3 add the LZ77 stage with deeper match searches
+constexpr int MAX_LEVEL = 3;
+
+//Deflate-style alphabets: 256 literals + 29 length codes, and 30 distance codes
+constexpr int LITLEN_ALPHABET_SIZE = 256 + 29;
+constexpr int DISTANCE_ALPHABET_SIZE = 30;
+
+//Matches reach back at most this far and are 3..258 bytes long
+constexpr int LZ_WINDOW_SIZE = 1 << 15;
+constexpr int LZ_MIN_MATCH = 3;
+constexpr int LZ_MAX_MATCH = 258;
+
+/**
+ * @brief Reusable state for leveled compression: match finder tables, token buffer and both Huffman tables
+ * */
+struct LzContext {
+  HuffmanContext huffman;
+  std::vector<int> head;      //most recent position of each 3-byte hash
+  std::vector<int> prev;      //previous position with the same hash, indexed by position % LZ_WINDOW_SIZE
+  std::vector<uint32_t> tokens;
+  std::vector<int> litlenFrequency;
+  std::vector<int> distanceFrequency;
+  std::vector<uint8_t> litlenLengths;
+  std::vector<uint8_t> distanceLengths;
+  std::vector<HuffmanCode> litlenCodes;
+  std::vector<HuffmanCode> distanceCodes;
+};
+
+/**
+ * @brief worst case size of compressLevel output
+ * A match costs at most 48 bits for 3 bytes, so 2 bytes per input byte covers every level.
+ * */
+constexpr size_t maxLevelCompressedSize(size_t rawSize) {
+  return 1 + 10 + 2 * (10 + (LITLEN_ALPHABET_SIZE + 1) / 2) + 2 * rawSize + 8;
+}
+
+/**
+ * @brief compress a buffer at a level, the output starts with a method byte
+ * Level 0 writes a compressBuffer() frame. Levels 1-3 run LZ77 with a hash-chain match finder first
+ * (chain depth 4 greedy, 32 lazy, 256 lazy) and Huffman-code literals/lengths and distances with
+ * two separate tables, as deflate does.
+ * With checksum set, the CRC32C of data is returned too (fused with the histogram at level 0).
+ * @params data, out (room for maxLevelCompressedSize(data.size())), level 0..MAX_LEVEL, context, checksum
+ * @return number of bytes written
+ * */
+size_t compressLevel(std::span<const uint8_t> data, uint8_t * out, int level, LzContext & context,
+                     uint32_t * checksum = nullptr);
+
+/**
+ * @brief decompress a buffer written by compressLevel at any level, the result replaces the contents of out
+ * The optional cache shares decode tables between blocks with identical code lengths.
+ * With checksum set, the CRC32C of the output is returned too.
+ * threads other than 1 decode level 0 frames of at least PARALLEL_DECODE_MIN_SIZE bytes with decodeParallel()
+ * (0 = hardware concurrency), for files made of a few very large blocks.
+ * A frame whose raw size is not expectedSize is rejected before any output is allocated.
+ * @return true on success, false if the input is malformed
+ * */
+bool decompressLevel(const uint8_t * in, size_t size, std::string & out, DecodeTableCache * cache = nullptr,
+                     uint32_t * checksum = nullptr, int threads = 1, uint64_t expectedSize = ANY_SIZE);
@@ -1,274 +1,127 @@
 #include <iostream>
+#include <limits>
 #include <ostream>
 #include <stdexcept>
 #include <vector>
 #include <fstream>
 #include <sstream>
 
+#include "heap.h"
+#include "pipeline.h"
+
 
 /**
- * @brief HeapNode structure that hold frequency, value, pointers to left and right child.
- * Provide comparision operator (> < =) based on the primary key (frequency) and secondary key (value)
+ * Helper function to build the codebook
+ * params pointer to parent node, a string with inital value, reference of an array of string to store the codebook
  * */
-template <typename Comparable>
-struct HeapNode {
-  int frequency; // Primary key
-  Comparable value; // Value and also a secondary key
-  HeapNode* left;   // Pointer to the left child
-  HeapNode* right;  // Pointer to the right child
-
-  //Constructor
-  HeapNode(int f, const Comparable & v) : frequency(f), value(v), left(nullptr), right(nullptr){}
-
-  // Less-than operator for comparing HeapNode objects by key
-  bool operator<(const HeapNode & other) const {
-    if (frequency == other.frequency) {
-      return value < other.value;
-    }
-    return frequency<other.frequency;
+void buildCodebook(const HeapNode<char> * parent, const std::string path, std::vector<std::string> & codebook) {
+  //reach the end
+  if (parent->left == nullptr && parent->right == nullptr) {
+    codebook[static_cast<unsigned int>(parent->value)] = path;
+    return;
   }
-
-  //Greater-than operator for comparing HeadNode objects by key
-  bool operator>(const HeapNode & other) const {
-    if (frequency == other.frequency) {
-      return value > other.value;
-    }
-    return frequency>other.frequency;
+  
+  if (parent->left != nullptr) {
+    buildCodebook(parent->left, path + "0", codebook );
   }
 
-  // Equal operator for comparing HeapNode objects
-  bool operator==(const HeapNode & other) const {
-    return frequency == other.frequency && value == other.value;
+  if (parent->right != nullptr) {
+    buildCodebook(parent->right, path + "1", codebook);
   }
 
-  // Overload the << operator for printing HeapNode
-  friend std::ostream &operator<<(std::ostream &os, const HeapNode &node) {
-    os << "{" << node.frequency << ":" << node.value << "}";
-    return os;
-  }
-};//end of HeapNode struct
+}
 
 /**
- * @brief Class that provides Minimum heap data structure
- * The data structure ensures storing comparable elements with the smallest key as the highest priority
- * Provide necessary functions to perform storing, and retrieving data
+ * Helper to run the file commands instead of the interactive report
+ * usage: main compress|decompress <input> <output> [--level 0-3] [--block-size N] [--queue-depth N] [--no-io-uring]
+ *        [--no-checksum] [--static-table] [--decode-threads N] [--lookup-bits N]
+ * return exit code
  * */
-template <typename Comparable>
-class MinHeap {
-  private:
-
-    //Dynamic array to store elements of the heap
-    std::vector<Comparable> heap;
-
-    /**
-     * @brief Private function to move the lower priority key down the tree.
-     * @params int index 
-     * @return nothing
-     * */
-    void percolateDown(int i) {
-      int leftChildIndex = 2 * i + 1;
-      int rightChildIndex = 2 * i + 2;
-      int smallestChildIndex = i;
-
-      if (leftChildIndex < static_cast<int>(heap.size()) && heap[leftChildIndex] < heap[smallestChildIndex]) {
-        smallestChildIndex = leftChildIndex;
-      }
-
-      if (rightChildIndex < static_cast<int>(heap.size()) && heap[rightChildIndex] < heap[smallestChildIndex]) {
-        smallestChildIndex = rightChildIndex;
-      }
-
-      if(smallestChildIndex != i){
-        std::swap(heap[i], heap[smallestChildIndex]);
-        percolateDown(smallestChildIndex);
-      }
-    }
-
-    /**
-     * @brief Private function to move the higher priority key up the tree
-     * @params int index
-     * @return nothing
-     * */
-    void percolateUp(int i) {
-      // Check if index is out of bounds
-      if (i >= static_cast<int>(heap.size())) {
-        std::cerr << "Error: Index " << i << " is out of bounds.\n";
-        return;  // Or throw an exception if you prefer
-      }
-
-      int currIndex = i;
-
-      while (currIndex > 0 && heap[currIndex] < heap[currIndex/2]) {
-        std::swap(heap[currIndex], heap[(currIndex - 1)/2]);
-        currIndex = (currIndex - 1)/2;
-      }
+int runFileCommand(int argc, char * argv[]) {
+  const std::string usage =
+      "Usage: main compress|decompress <input> <output> [--level 0-3] [--block-size N] [--queue-depth N] [--no-io-uring]"
+      " [--no-checksum] [--static-table] [--decode-threads N] [--lookup-bits N]";
+  if (argc < 4) {
+    std::cerr << usage << std::endl;
+    return 1;
+  }
 
+  std::string command = argv[1];
+  PipelineOptions options;
+  for (int i = 4; i < argc; i++) {
+    std::string flag = argv[i];
+    if (flag == "--no-io-uring") {
+      options.useIoUring = false;
     }
-
-    /**
-     * @brief function that build out a heap structure from an array
-     * Helper for constructor when users want to initialize the heap with an array
-     * @params: nothing
-     * @return: nothing
-     * */
-    void buildHeap() {
-      for (int i = static_cast<int>((heap.size()/2 - 1)); i >= 0; i--){
-        percolateDown(i);
-      }
+    else if (flag == "--no-checksum") {
+      options.checksums = false;
     }
-
-    /**
-     * @brief private function to insert an element into the heap
-     * @params: const Comparable & node 
-     * @return nothing
-     * */
-    void privateInsert(const Comparable & node) {
-      heap.push_back(node); //Inser the element to the back of the heap array
-      percolateUp(static_cast<int>(heap.size()-1)); //move the inserted element to ensure heap structure
-
+    else if (flag == "--static-table") {
+      options.staticTable = true;
     }
-
-    /**
-     * @brief private function to retrieve and remove an element from the top of the heap (highest priority)
-     * @params nothing
-     * @return Comparable minElement
-     * */
-    Comparable privateDeleteMin() {
-      if (heap.empty()) {
-        throw std::runtime_error("Heap is empty");
+    else if ((flag == "--block-size" || flag == "--queue-depth" || flag == "--level" || flag == "--decode-threads" ||
+              flag == "--lookup-bits") &&
+             i + 1 < argc) {
+      std::stringstream ss(argv[++i]);
+      unsigned long value = 0;
+      bool parsed = (ss >> value) && ss.eof();
+      //everything but --block-size is an int, reject values that would wrap in the cast below
+      bool tooLarge = flag != "--block-size" && value > static_cast<unsigned long>(std::numeric_limits<int>::max());
+      bool zeroAllowed = flag == "--level" || flag == "--decode-threads" || flag == "--lookup-bits";
+      if (!parsed || (value == 0 && !zeroAllowed) || tooLarge) {
+        std::cerr << "Invalid value for " << flag << std::endl;
+        return 1;
       }
-
-      Comparable minElement = heap[0]; // Copy the element
-      heap[0] = heap[heap.size() - 1]; // Swap it with the last element
-      heap.pop_back(); // Remove the last element
-                       //
-      //If the heap is not empty after removal percolate element at root down
-      if (!heap.empty()) {
-        percolateDown(0);
+      if (flag == "--block-size") {
+        options.blockSize = value;
       }
-
-      return minElement; //return the copy
-    }
-
-
-    /**
-     * @brief Private function that return the value of the highest priority element
-     * This function does not remove the element from the heap
-     * @params nothing
-     * @return const Comparable & element
-     * */
-    const Comparable & privateMin() const {
-      if (heap.empty()) {
-        throw std::runtime_error("Heap is empty");
+      else if (flag == "--level") {
+        options.level = static_cast<int>(value);
       }
-      return heap[0];
-    }
-
-    /**
-     * @brief Function to display the heap to stdout
-     * */
-    void privateDisplay(){
-      if (heap.empty()) {
-        std::cerr << "Heap is empty" << std::endl;
-        return;
+      else if (flag == "--decode-threads") {
+        options.decodeThreads = static_cast<int>(value);
       }
-      for (auto & element : heap) {
-        std::cout << element << ", ";
+      else if (flag == "--lookup-bits") {
+        options.lookupBits = static_cast<int>(value);
       }
-      std::cout << std::endl;
-    }
-
-
-  public:
-    
-    /**
-     * Constructor that handles both an empty heap or an array of HeapNode
-     * If user initialize with an array, constructor calls buildHeap() function to 
-     * build a heap out of that array.
-     * If nothing is given, an empty heap is created.
-     * */    
-    explicit MinHeap(const std::vector<Comparable> & arr = {}) : heap(arr){
-      if(!heap.empty()) {
-        buildHeap();
+      else {
+        options.queueDepth = static_cast<int>(value);
       }
-    };
-
-    /**
-     * @brief public function that check if the heap is empty
-     * @return true/false
-     * */
-    bool empty() {
-      return heap.empty();
     }
-
-    /** 
-     * @brief public funtion that return current size of the heap
-     * @return int size
-     * */
-    int size() {
-      return static_cast<int>(this->heap.size());
-    }
-    /**
-     * @brief public function that insert an element to the heap
-     * @params const Comparable & node 
-     * @return nothing
-     * */
-    void insert(const Comparable & node) {
-      privateInsert(node);
-    } 
-
-    /**
-     * @brief public funtion that delete the highest priority element from the heap and return that element
-     * @params nothing
-     * @return Comparable element 
-     * */
-    Comparable deleteMin() {
-      return privateDeleteMin();
+    else {
+      std::cerr << usage << std::endl;
+      return 1;
     }
+  }
 
-    /**
-     * @brief public function that return the value of the highest priority element
-     * This function does not remove the element from the heap
-     * @params nothing
-     * @return const Comparable & element
-     * */
-    const Comparable & min() const {
-      return privateMin();
+  try {
+    PipelineResult result;
+    if (command == "compress") {
+      result = compressFile(argv[2], argv[3], options);
     }
-
-    /**
-     * @brief public funtion to display the heap to stdout 
-     * */
-    void display() {
-      this->privateDisplay();
+    else if (command == "decompress") {
+      result = decompressFile(argv[2], argv[3], options);
     }
-    
-  }; //end MinHeap Class
-
-
-/**
- * Helper function to build the codebook
- * params pointer to parent node, a string with inital value, reference of an array of string to store the codebook
- * */
-void buildCodebook(const HeapNode<char> * parent, const std::string path, std::vector<std::string> & codebook) {
-  //reach the end
-  if (parent->left == nullptr && parent->right == nullptr) {
-    codebook[static_cast<unsigned int>(parent->value)] = path;
-    return;
-  }
-  
-  if (parent->left != nullptr) {
-    buildCodebook(parent->left, path + "0", codebook );
+    else {
+      std::cerr << usage << std::endl;
+      return 1;
+    }
+    std::cout << command << ": " << result.inputBytes << " -> " << result.outputBytes << " bytes in "
+              << result.blocks << " blocks" << (result.usedIoUring ? " (io_uring)" : "") << std::endl;
   }
-
-  if (parent->right != nullptr) {
-    buildCodebook(parent->right, path + "1", codebook);
+  catch (const std::exception & e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
   }
-
+  return 0;
 }
 
 //===MAIN PROGRAM===//
-int main(){
+int main(int argc, char * argv[]){
+  //File commands skip the interactive report
+  if (argc > 1) {
+    return runFileCommand(argc, argv);
+  }
   
   //====== READ FROM FILE =====//
   std::ifstream inputFile("merchant.txt"); // Open the file
@@ -397,7 +250,7 @@ int main(){
 
   for (char ch : inString) {
     // Get the Huffman encoding from codebook
-    std::string huffmanCode = codeBook[static_cast<unsigned char>(ch)];
+    const std::string & huffmanCode = codeBook[static_cast<unsigned char>(ch)];
 
     // Calculate the bit length of the Huffman code and update totals
     int huffmanBits = huffmanCode.length();
@@ -408,7 +261,8 @@ int main(){
     asciiBitTotal += asciiBits;
 
     // Append the line to outString
-    outString += huffmanCode + "\t\t" + std::to_string(huffmanBitTotal) + "\t\t" + std::to_string(asciiBitTotal) + "\n";
+    outString.append(huffmanCode).append("\t\t").append(std::to_string(huffmanBitTotal))
+             .append("\t\t").append(std::to_string(asciiBitTotal)).append("\n");
   }
 
 
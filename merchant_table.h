@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+
+#include "huffman.h"
+#include "static_codec.h"
+
+
+/**
+ * Byte frequencies of merchant.txt, the training set for the built-in static codebook.
+ * Bytes that never occur were given a count of 1 so any input stays encodable.
+ * Regenerate with: python3 -c "d=open('merchant.txt','rb').read(); print([max(d.count(i),1) for i in range(256)])"
+ * */
+inline constexpr std::array<int, ALPHABET_SIZE> MERCHANT_FREQUENCY = {
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 4908, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  18623, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 7254, 1513, 2013, 3394, 10621, 1950, 1576,
+  5711, 6208, 222, 751, 3880, 2526, 6015, 7948,
+  1226, 56, 5317, 5864, 7946, 2909, 884, 2158,
+  106, 2440, 110, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1,
+};
+
+//Static codebook trained on merchant.txt, built by the compiler
+inline constexpr auto MERCHANT_CODEBOOK = makeStaticCodebook<12>(MERCHANT_FREQUENCY);
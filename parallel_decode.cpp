@@ -0,0 +1,183 @@
+#include "parallel_decode.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+
+//Speculative symbol boundaries kept per range; resynchronization almost always happens within a few dozen
+constexpr size_t SYNC_WINDOW = 1024;
+
+//Below this many bits per thread the threads cost more than they save
+constexpr uint64_t MIN_BITS_PER_THREAD = 1 << 16;
+
+/**
+ * @brief Output of one speculatively decoded bit range
+ * */
+struct Segment {
+  uint64_t startBit = 0;
+  uint64_t endBit = 0;
+  std::vector<uint8_t> symbols;
+  size_t symbolCount = 0;
+  std::vector<uint64_t> boundaries; //start bit of the first SYNC_WINDOW symbols
+  uint64_t exitBit = 0;             //first symbol start at or after endBit
+};
+
+/**
+ * Helper decoding every symbol that starts in [from, segment.endBit)
+ * records boundaries when recordBoundaries is set
+ * return the bit position after the last symbol
+ * */
+static uint64_t decodeRange(const uint8_t * in, size_t size, const DecodeTable & table, uint64_t from, Segment & segment,
+                            bool recordBoundaries) {
+  BitReader reader(in, size, from);
+  uint8_t * out = segment.symbols.data();
+  size_t produced = 0;
+
+  while (true) {
+    reader.refill();
+    //One refill covers 3 codes of any length
+    static_assert(3 * MAX_CODE_LENGTH <= MIN_REFILL_BITS);
+    for (int k = 0; k < 3; k++) {
+      uint64_t position = reader.bitPosition();
+      if (position >= segment.endBit) {
+        segment.symbolCount = produced;
+        return position;
+      }
+      if (recordBoundaries && produced < SYNC_WINDOW) {
+        segment.boundaries.push_back(position);
+      }
+      out[produced++] = static_cast<uint8_t>(decodeSymbol(reader, table));
+    }
+  }
+}
+
+bool decodeParallel(const uint8_t * in, size_t size, const DecodeTable & table, uint8_t * out, size_t count,
+                    int threads) {
+  const uint64_t totalBits = static_cast<uint64_t>(size) * 8;
+  if (threads <= 0) {
+    threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+  }
+  threads = static_cast<int>(std::min<uint64_t>(static_cast<uint64_t>(threads), totalBits / MIN_BITS_PER_THREAD));
+  if (threads <= 1) {
+    return decodeSymbols(in, size, table, out, count);
+  }
+
+  std::vector<Segment> segments(static_cast<size_t>(threads));
+  for (size_t i = 0; i < segments.size(); i++) {
+    Segment & segment = segments[i];
+    segment.startBit = totalBits * i / segments.size();
+    segment.endBit = totalBits * (i + 1) / segments.size();
+    //Symbols start at least table.shortest bits apart, wherever decoding starts in the range
+    segment.symbols.resize(static_cast<size_t>((segment.endBit - segment.startBit) / table.shortest) + 1);
+    segment.boundaries.reserve(SYNC_WINDOW);
+  }
+
+  //Range 0 starts on a real code boundary and runs on this thread, the others speculate
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < segments.size(); i++) {
+    workers.emplace_back([&, i] {
+      segments[i].exitBit = decodeRange(in, size, table, segments[i].startBit, segments[i], true);
+    });
+  }
+  segments[0].exitBit = decodeRange(in, size, table, 0, segments[0], false);
+  for (std::thread & worker : workers) {
+    worker.join();
+  }
+
+  //Stitch in order: decode from the true entry point until it meets a speculative boundary
+  //A truncated stream shows up as the last wanted symbol ending past the input. Only the final symbol of a
+  //chunk can do that: any other symbol is followed by one that starts inside the input.
+  size_t produced = 0;
+  uint64_t lastSymbolEnd = 0;
+  auto append = [&](const uint8_t * symbols, size_t n, uint64_t chunkEnd) {
+    size_t take = std::min(n, count - produced);
+    if (take > 0) {
+      std::memcpy(out + produced, symbols, take);
+    }
+    produced += take;
+    if (produced == count && take == n) {
+      lastSymbolEnd = chunkEnd;
+    }
+  };
+  append(segments[0].symbols.data(), segments[0].symbolCount, segments[0].exitBit);
+  uint64_t entryBit = segments[0].exitBit;
+
+  std::vector<uint8_t> gap;
+  for (size_t i = 1; i < segments.size() && produced < count; i++) {
+    Segment & segment = segments[i];
+    BitReader reader(in, size, entryBit);
+    gap.clear();
+    size_t next = 0;
+    bool synced = false;
+
+    while (true) {
+      uint64_t position = reader.bitPosition();
+      if (position >= segment.endBit) {
+        break;
+      }
+      while (next < segment.boundaries.size() && segment.boundaries[next] < position) {
+        next++;
+      }
+      if (next < segment.boundaries.size() && segment.boundaries[next] == position) {
+        synced = true;
+        break;
+      }
+      if (next == segment.boundaries.size() && segment.boundaries.size() == SYNC_WINDOW) {
+        break; //past the recorded window, decode the rest of the range directly
+      }
+      reader.refill();
+      gap.push_back(static_cast<uint8_t>(decodeSymbol(reader, table)));
+    }
+
+    uint64_t resume = reader.bitPosition();
+    append(gap.data(), gap.size(), resume);
+    if (synced) {
+      append(segment.symbols.data() + next, segment.symbolCount - next, segment.exitBit);
+      entryBit = segment.exitBit;
+    }
+    else if (resume < segment.endBit) {
+      //No resynchronization: decode the rest of the range from the true position
+      entryBit = decodeRange(in, size, table, resume, segment, false);
+      append(segment.symbols.data(), segment.symbolCount, entryBit);
+    }
+    else {
+      entryBit = resume;
+    }
+  }
+
+  return produced == count && lastSymbolEnd <= totalBits;
+}
+
+bool decompressBufferParallel(const uint8_t * in, size_t size, std::string & out, int threads,
+                              DecodeTableCache * cache, uint64_t expectedSize) {
+  uint64_t rawSize = 0;
+  size_t pos = readVarint(in, size, rawSize);
+  if (pos == 0 || (expectedSize != ANY_SIZE && rawSize != expectedSize)) {
+    return false;
+  }
+  out.clear();
+  if (rawSize == 0) {
+    return true;
+  }
+
+  uint8_t lengths[ALPHABET_SIZE];
+  size_t headerSize = readCodeLengths(in + pos, size - pos, lengths);
+  if (headerSize == 0) {
+    return false;
+  }
+  pos += headerSize;
+
+  if (rawSize > (size - pos) * 8) {
+    return false;
+  }
+  DecodeTable local;
+  std::shared_ptr<const DecodeTable> cached;
+  const DecodeTable * table = acquireDecodeTable(lengths, cache, local, cached);
+  if (table == nullptr) {
+    return false;
+  }
+  out.resize(rawSize);
+  return decodeParallel(in + pos, size - pos, *table, reinterpret_cast<uint8_t *>(out.data()), rawSize, threads);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "decoder.h"
+
+
+/**
+ * @brief decode one Huffman bitstream on several threads
+ * The stream is cut into equal bit ranges. Every thread but the first starts decoding at the first bit of its
+ * range without knowing where a code starts there. Huffman codes resynchronize after a few symbols, so once
+ * the true decode from the previous range's exit point lands on one of the speculative symbol boundaries,
+ * the rest of the speculative output is correct. The stitch step decodes only that short gap again. A range
+ * that never resynchronizes is decoded again in full, so the result is always exact.
+ * Works on plain encodeSymbols()/compressBuffer() payloads, the format is unchanged.
+ * @params in, size, table, out, count, threads (0 = hardware concurrency)
+ * @return false if the stream is shorter than count symbols need
+ * */
+bool decodeParallel(const uint8_t * in, size_t size, const DecodeTable & table, uint8_t * out, size_t count,
+                    int threads = 0);
+
+//Frames with fewer compressed bytes than this decode faster on one thread than split up
+constexpr size_t PARALLEL_DECODE_MIN_SIZE = 1 << 20;
+
+/**
+ * @brief decompressBuffer() with the payload decoded by decodeParallel()
+ * A frame whose raw size is not expectedSize is rejected before any output is allocated.
+ * @return true on success, false if the input is malformed
+ * */
+bool decompressBufferParallel(const uint8_t * in, size_t size, std::string & out, int threads = 0,
+                              DecodeTableCache * cache = nullptr, uint64_t expectedSize = ANY_SIZE);
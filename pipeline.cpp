@@ -0,0 +1,649 @@
+#include "pipeline.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define HUFFMAN_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "container.h"
+#include "decoder.h"
+#include "huffman.h"
+#include "lz.h"
+
+
+/**
+ * @brief Open file descriptor closed on scope exit
+ * */
+class FileHandle {
+  private:
+    int fd;
+
+  public:
+    FileHandle(const std::string & path, int flags) : fd(::open(path.c_str(), flags, 0644)) {
+      if (fd < 0) {
+        throw std::runtime_error("Error opening " + path + ": " + std::strerror(errno));
+      }
+    }
+
+    ~FileHandle() {
+      ::close(fd);
+    }
+
+    FileHandle(const FileHandle &) = delete;
+    FileHandle & operator=(const FileHandle &) = delete;
+
+    int get() const {
+      return fd;
+    }
+}; //end FileHandle Class
+
+/**
+ * @brief One block buffer of the pipeline and where it currently is
+ * */
+enum class SlotState { Free, Reading, Read, Computed, Writing };
+
+struct Slot {
+  std::vector<uint8_t> input;
+  size_t inputSize = 0;
+  std::vector<uint8_t> output;
+  size_t outputSize = 0;
+  std::string decoded;     //decompression output
+  BlockHeader block;       //header of the block being decompressed
+  uint64_t readOffset = 0; //file offsets, used by the io_uring path to finish short transfers
+  uint64_t writeOffset = 0;
+  size_t transferred = 0;
+  SlotState state = SlotState::Free;
+};
+
+/**
+ * Helper to read up to size bytes at offset, retrying short reads
+ * @return bytes read, less than size only at end of file
+ * */
+static size_t readFully(int fd, uint8_t * buffer, size_t size, uint64_t offset) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = ::pread(fd, buffer + done, size - done, static_cast<off_t>(offset + done));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("Read failed: ") + std::strerror(errno));
+    }
+    if (n == 0) {
+      break;
+    }
+    done += static_cast<size_t>(n);
+  }
+  return done;
+}
+
+/**
+ * Helper to write all size bytes at offset
+ * */
+static void writeFully(int fd, const uint8_t * buffer, size_t size, uint64_t offset) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = ::pwrite(fd, buffer + done, size - done, static_cast<off_t>(offset + done));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("Write failed: ") + std::strerror(errno));
+    }
+    done += static_cast<size_t>(n);
+  }
+}
+
+/**
+ * Helper to compress the block held by a slot into its output buffer as block header + payload
+ * */
+static void compressSlot(Slot & slot, const ContainerHeader & header, LzContext & context) {
+  slot.outputSize = encodeBlock({slot.input.data(), slot.inputSize}, slot.output.data(), header, context);
+}
+
+/**
+ * @brief Thread fallback: a reader thread, the calling thread computing, and a writer thread
+ * Blocks move through the slots in order, block n always uses slot n % slots.size().
+ * readBlock returns false at the end of the input.
+ * @return number of blocks processed
+ * */
+template <typename ReadFn, typename ComputeFn, typename WriteFn>
+static size_t runThreadPipeline(std::vector<Slot> & slots, ReadFn readBlock, ComputeFn computeBlock, WriteFn writeBlock) {
+  std::mutex mutex;
+  std::condition_variable changed;
+  size_t totalBlocks = SIZE_MAX; //known once the reader hits the end
+  std::exception_ptr error;
+  const size_t depth = slots.size();
+
+  //Wait until the slot of block reaches state. False means stop: the input ended or a stage failed.
+  auto waitFor = [&](size_t block, SlotState state) {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&] { return error || block >= totalBlocks || slots[block % depth].state == state; });
+    return !error && block < totalBlocks;
+  };
+  auto publish = [&](size_t block, SlotState state) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      slots[block % depth].state = state;
+    }
+    changed.notify_all();
+  };
+  auto fail = [&](std::exception_ptr e) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error) {
+        error = e;
+      }
+    }
+    changed.notify_all();
+  };
+
+  std::thread reader([&] {
+    try {
+      for (size_t block = 0; waitFor(block, SlotState::Free); block++) {
+        if (!readBlock(slots[block % depth])) {
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            totalBlocks = block;
+          }
+          changed.notify_all();
+          return;
+        }
+        publish(block, SlotState::Read);
+      }
+    }
+    catch (...) {
+      fail(std::current_exception());
+    }
+  });
+
+  std::thread writer([&] {
+    try {
+      for (size_t block = 0; waitFor(block, SlotState::Computed); block++) {
+        writeBlock(slots[block % depth]);
+        publish(block, SlotState::Free);
+      }
+    }
+    catch (...) {
+      fail(std::current_exception());
+    }
+  });
+
+  try {
+    for (size_t block = 0; waitFor(block, SlotState::Read); block++) {
+      computeBlock(slots[block % depth]);
+      publish(block, SlotState::Computed);
+    }
+  }
+  catch (...) {
+    fail(std::current_exception());
+  }
+
+  reader.join();
+  writer.join();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  return totalBlocks;
+}
+
+#ifdef HUFFMAN_HAVE_IO_URING
+/**
+ * @brief Minimal io_uring wrapper on the raw syscalls (no liburing dependency)
+ * Only what the pipeline needs: queue reads/writes, submit, and reap completions.
+ * */
+class IoUring {
+  private:
+    int ringFd = -1;
+    void * sqRing = MAP_FAILED;
+    void * cqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    io_uring_sqe * sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned * sqTail = nullptr;
+    unsigned * sqMask = nullptr;
+    unsigned * sqArray = nullptr;
+    unsigned * cqHead = nullptr;
+    unsigned * cqTail = nullptr;
+    unsigned * cqMask = nullptr;
+    io_uring_cqe * cqes = nullptr;
+    unsigned toSubmit = 0;
+    unsigned inFlight = 0; //queued requests whose completion has not been popped yet
+
+    /**
+     * Helper to map one of the ring regions
+     * */
+    void * mapRegion(size_t size, off_t offset) {
+      return ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, offset);
+    }
+
+  public:
+    IoUring() = default;
+    IoUring(const IoUring &) = delete;
+    IoUring & operator=(const IoUring &) = delete;
+
+    ~IoUring() {
+      //Requests still in flight point into caller buffers, wait for them before those can be freed
+      drain();
+      if (sqes != MAP_FAILED) {
+        ::munmap(sqes, sqesSize);
+      }
+      if (cqRing != MAP_FAILED && cqRing != sqRing) {
+        ::munmap(cqRing, cqRingSize);
+      }
+      if (sqRing != MAP_FAILED) {
+        ::munmap(sqRing, sqRingSize);
+      }
+      if (ringFd >= 0) {
+        ::close(ringFd);
+      }
+    }
+
+    /**
+     * @brief create the ring, false if the kernel does not support or allow io_uring
+     * */
+    bool init(unsigned entries) {
+      io_uring_params params;
+      std::memset(&params, 0, sizeof(params));
+      ringFd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+      if (ringFd < 0) {
+        return false;
+      }
+
+      sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+      cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+      bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+      if (singleMap) {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+      }
+
+      sqRing = mapRegion(sqRingSize, IORING_OFF_SQ_RING);
+      if (sqRing == MAP_FAILED) {
+        return false;
+      }
+      cqRing = singleMap ? sqRing : mapRegion(cqRingSize, IORING_OFF_CQ_RING);
+      if (cqRing == MAP_FAILED) {
+        return false;
+      }
+      sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+      sqes = static_cast<io_uring_sqe *>(mapRegion(sqesSize, IORING_OFF_SQES));
+      if (sqes == MAP_FAILED) {
+        return false;
+      }
+
+      char * sq = static_cast<char *>(sqRing);
+      char * cq = static_cast<char *>(cqRing);
+      sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+      sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+      sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+      cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+      cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+      cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+      cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+      return true;
+    }
+
+    /**
+     * @brief ask the kernel whether it implements opcode
+     * io_uring_setup works since 5.1 but IORING_OP_READ/WRITE only arrived in 5.6, together with the probe.
+     * Older kernels reject the probe itself, which reads as unsupported.
+     * */
+    bool supports(uint8_t opcode) {
+      const unsigned maxOps = 256;
+      std::vector<uint8_t> buffer(sizeof(io_uring_probe) + maxOps * sizeof(io_uring_probe_op), 0);
+      io_uring_probe * probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+      if (::syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, maxOps) < 0) {
+        return false;
+      }
+      return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) != 0;
+    }
+
+    /**
+     * @brief queue a read or write (IORING_OP_READ / IORING_OP_WRITE), sent on the next submit()
+     * The caller keeps at most sq_entries requests in flight.
+     * */
+    void prepare(uint8_t opcode, int fd, void * buffer, size_t size, uint64_t offset, uint64_t userData) {
+      unsigned tail = *sqTail;
+      unsigned index = tail & *sqMask;
+      io_uring_sqe * sqe = &sqes[index];
+      std::memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = opcode;
+      sqe->fd = fd;
+      sqe->addr = reinterpret_cast<uint64_t>(buffer);
+      sqe->len = static_cast<uint32_t>(size);
+      sqe->off = offset;
+      sqe->user_data = userData;
+      sqArray[index] = index;
+      __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+      toSubmit++;
+      inFlight++;
+    }
+
+    /**
+     * @brief submit queued requests and wait for at least waitCount completions
+     * */
+    void submit(unsigned waitCount) {
+      while (true) {
+        long n = ::syscall(__NR_io_uring_enter, ringFd, toSubmit, waitCount,
+                           waitCount > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+        if (n >= 0) {
+          toSubmit -= static_cast<unsigned>(n);
+          return;
+        }
+        if (errno != EINTR) {
+          throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+        }
+      }
+    }
+
+    /**
+     * @brief take one completion if there is one
+     * @return false when the completion queue is empty
+     * */
+    bool popCompletion(uint64_t & userData, int & result) {
+      unsigned head = *cqHead;
+      if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+        return false;
+      }
+      const io_uring_cqe & cqe = cqes[head & *cqMask];
+      userData = cqe.user_data;
+      result = cqe.res;
+      __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+      inFlight--;
+      return true;
+    }
+
+    /**
+     * @brief submit anything queued and wait until every request has completed, completions are discarded
+     * Used when unwinding, so it never throws: if the kernel refuses to wait there is nothing left to do.
+     * */
+    void drain() noexcept {
+      uint64_t userData = 0;
+      int result = 0;
+      while (inFlight > 0 && ringFd >= 0) {
+        long n = ::syscall(__NR_io_uring_enter, ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (n < 0 && errno != EINTR) {
+          return;
+        }
+        if (n > 0) {
+          toSubmit -= static_cast<unsigned>(n);
+        }
+        while (popCompletion(userData, result)) {
+        }
+      }
+    }
+}; //end IoUring Class
+
+/**
+ * @brief io_uring compressor: reads and writes are asynchronous, the calling thread only compresses
+ * Up to slots.size() reads are queued ahead, each compressed block is queued for writing immediately,
+ * and the thread only blocks in the kernel when no block is ready to compress.
+ * Blocks are written from outputBytes on, which is advanced past the last one.
+ * On an error the ring waits for the requests still in flight before the exception leaves this function.
+ * @return number of blocks, or SIZE_MAX if io_uring or its read/write opcodes are not available
+ * */
+static size_t compressWithIoUring(int inputFd, int outputFd, uint64_t fileSize, const ContainerHeader & header,
+                                  std::vector<Slot> & slots, LzContext & context, uint64_t & outputBytes) {
+  IoUring ring;
+  if (!ring.init(static_cast<unsigned>(2 * slots.size())) || !ring.supports(IORING_OP_READ) ||
+      !ring.supports(IORING_OP_WRITE)) {
+    return SIZE_MAX;
+  }
+
+  const size_t depth = slots.size();
+  const size_t blockSize = header.blockSize;
+  const size_t totalBlocks = static_cast<size_t>((fileSize + blockSize - 1) / blockSize);
+  size_t nextRead = 0;
+  size_t nextCompute = 0;
+  size_t written = 0;
+  uint64_t writeOffset = outputBytes;
+
+  //user_data = slot index * 2 + 1 for writes
+  auto queueRead = [&](size_t index) {
+    Slot & slot = slots[index];
+    ring.prepare(IORING_OP_READ, inputFd, slot.input.data() + slot.transferred, slot.inputSize - slot.transferred,
+                 slot.readOffset + slot.transferred, index * 2);
+  };
+  auto queueWrite = [&](size_t index) {
+    Slot & slot = slots[index];
+    ring.prepare(IORING_OP_WRITE, outputFd, slot.output.data() + slot.transferred, slot.outputSize - slot.transferred,
+                 slot.writeOffset + slot.transferred, index * 2 + 1);
+  };
+
+  while (written < totalBlocks) {
+    while (nextRead < totalBlocks && slots[nextRead % depth].state == SlotState::Free) {
+      Slot & slot = slots[nextRead % depth];
+      slot.readOffset = static_cast<uint64_t>(nextRead) * blockSize;
+      slot.inputSize = static_cast<size_t>(std::min<uint64_t>(blockSize, fileSize - slot.readOffset));
+      slot.transferred = 0;
+      slot.state = SlotState::Reading;
+      queueRead(nextRead % depth);
+      nextRead++;
+    }
+
+    bool computed = false;
+    if (nextCompute < totalBlocks && slots[nextCompute % depth].state == SlotState::Read) {
+      Slot & slot = slots[nextCompute % depth];
+      compressSlot(slot, header, context);
+      slot.writeOffset = writeOffset;
+      writeOffset += slot.outputSize;
+      slot.transferred = 0;
+      slot.state = SlotState::Writing;
+      queueWrite(nextCompute % depth);
+      nextCompute++;
+      computed = true;
+    }
+
+    //Only sleep in the kernel when there was nothing to compute
+    ring.submit(computed ? 0 : 1);
+
+    uint64_t userData = 0;
+    int result = 0;
+    while (ring.popCompletion(userData, result)) {
+      size_t index = static_cast<size_t>(userData / 2);
+      bool isWrite = (userData & 1) != 0;
+      Slot & slot = slots[index];
+      if (result < 0) {
+        throw std::runtime_error(std::string(isWrite ? "Write" : "Read") + " failed: " + std::strerror(-result));
+      }
+      if (result == 0 && !isWrite) {
+        throw std::runtime_error("Input file shrank while compressing");
+      }
+
+      slot.transferred += static_cast<size_t>(result);
+      size_t expected = isWrite ? slot.outputSize : slot.inputSize;
+      if (slot.transferred < expected) {
+        //Short transfer, queue the rest
+        if (isWrite) {
+          queueWrite(index);
+        }
+        else {
+          queueRead(index);
+        }
+      }
+      else if (isWrite) {
+        slot.state = SlotState::Free;
+        written++;
+      }
+      else {
+        slot.state = SlotState::Read;
+      }
+    }
+  }
+
+  outputBytes = writeOffset;
+  return totalBlocks;
+}
+#endif
+
+PipelineResult compressFile(const std::string & inputPath, const std::string & outputPath,
+                            const PipelineOptions & options) {
+  if (options.blockSize == 0 || options.blockSize > MAX_CONTAINER_BLOCK_SIZE || options.queueDepth < 1 ||
+      options.level < 0 || options.level > MAX_LEVEL) {
+    throw std::runtime_error("Invalid pipeline options");
+  }
+
+  ContainerHeader header;
+  header.flags = options.checksums ? CONTAINER_FLAG_BLOCK_CHECKSUMS : 0;
+  header.tableType = options.staticTable ? TableType::StaticMerchant : TableType::Dynamic;
+  header.level = static_cast<uint8_t>(options.staticTable ? 0 : options.level);
+  header.blockSize = static_cast<uint32_t>(options.blockSize);
+
+  FileHandle input(inputPath, O_RDONLY);
+  FileHandle output(outputPath, O_WRONLY | O_CREAT | O_TRUNC);
+  struct stat info;
+  if (::fstat(input.get(), &info) != 0) {
+    throw std::runtime_error("Error reading size of " + inputPath);
+  }
+
+  std::vector<Slot> slots(static_cast<size_t>(options.queueDepth));
+  for (Slot & slot : slots) {
+    slot.input.resize(options.blockSize);
+    slot.output.resize(maxBlockFrameSize(options.blockSize));
+  }
+  LzContext context;
+
+  uint8_t fileHeader[CONTAINER_HEADER_SIZE];
+  writeContainerHeader(header, fileHeader);
+  writeFully(output.get(), fileHeader, sizeof(fileHeader), 0);
+
+  PipelineResult result;
+  result.inputBytes = static_cast<uint64_t>(info.st_size);
+  result.outputBytes = CONTAINER_HEADER_SIZE;
+
+  auto writeEndMarker = [&] {
+    uint8_t marker[BLOCK_HEADER_SIZE];
+    writeBlockHeader(BlockHeader{}, marker);
+    writeFully(output.get(), marker, sizeof(marker), result.outputBytes);
+    result.outputBytes += sizeof(marker);
+  };
+
+#ifdef HUFFMAN_HAVE_IO_URING
+  if (options.useIoUring) {
+    size_t blocks = compressWithIoUring(input.get(), output.get(), result.inputBytes, header, slots, context,
+                                        result.outputBytes);
+    if (blocks != SIZE_MAX) {
+      result.blocks = blocks;
+      result.usedIoUring = true;
+      writeEndMarker();
+      return result;
+    }
+  }
+#endif
+
+  uint64_t readOffset = 0;
+  uint64_t writeOffset = result.outputBytes;
+  result.blocks = runThreadPipeline(
+      slots,
+      [&](Slot & slot) {
+        slot.inputSize = readFully(input.get(), slot.input.data(), options.blockSize, readOffset);
+        readOffset += slot.inputSize;
+        return slot.inputSize > 0;
+      },
+      [&](Slot & slot) { compressSlot(slot, header, context); },
+      [&](Slot & slot) {
+        writeFully(output.get(), slot.output.data(), slot.outputSize, writeOffset);
+        writeOffset += slot.outputSize;
+      });
+  result.outputBytes = writeOffset;
+  writeEndMarker();
+  return result;
+}
+
+PipelineResult decompressFile(const std::string & inputPath, const std::string & outputPath,
+                              const PipelineOptions & options) {
+  if (options.queueDepth < 1 || options.decodeThreads < 0 || options.lookupBits < 0 ||
+      options.lookupBits > MAX_CODE_LENGTH) {
+    throw std::runtime_error("Invalid pipeline options");
+  }
+
+  FileHandle input(inputPath, O_RDONLY);
+  uint8_t fileHeader[CONTAINER_HEADER_SIZE];
+  ContainerHeader header;
+  if (readFully(input.get(), fileHeader, sizeof(fileHeader), 0) != sizeof(fileHeader) ||
+      !readContainerHeader(fileHeader, header)) {
+    throw std::runtime_error("Not a compressed file or unsupported version: " + inputPath);
+  }
+  const size_t maxPayload = maxLevelCompressedSize(header.blockSize);
+
+  FileHandle output(outputPath, O_WRONLY | O_CREAT | O_TRUNC);
+  std::vector<Slot> slots(static_cast<size_t>(options.queueDepth));
+
+  PipelineResult result;
+  DecodeTableCache cache(256, options.lookupBits > 0 ? options.lookupBits : DEFAULT_LOOKUP_BITS);
+  uint64_t readOffset = CONTAINER_HEADER_SIZE;
+  uint64_t writeOffset = 0;
+  size_t decodedBlocks = 0;
+  result.blocks = runThreadPipeline(
+      slots,
+      [&](Slot & slot) {
+        uint8_t blockHeader[BLOCK_HEADER_SIZE];
+        if (readFully(input.get(), blockHeader, sizeof(blockHeader), readOffset) != sizeof(blockHeader)) {
+          throw std::runtime_error("Truncated file, block header missing at offset " + std::to_string(readOffset));
+        }
+        slot.block = readBlockHeader(blockHeader);
+        readOffset += sizeof(blockHeader);
+        if (slot.block.compressedSize == 0) {
+          if (slot.block.uncompressedSize != 0 || slot.block.checksum != 0) {
+            throw std::runtime_error("Corrupt end marker at offset " + std::to_string(readOffset));
+          }
+          //The end marker must also be the end of the file
+          struct stat info;
+          if (::fstat(input.get(), &info) != 0 || static_cast<uint64_t>(info.st_size) != readOffset) {
+            throw std::runtime_error("Unexpected data after end marker at offset " + std::to_string(readOffset));
+          }
+          return false;
+        }
+        if (slot.block.compressedSize > maxPayload || slot.block.uncompressedSize == 0 ||
+            slot.block.uncompressedSize > header.blockSize) {
+          throw std::runtime_error("Corrupt block header at offset " + std::to_string(readOffset));
+        }
+        if (slot.input.size() < slot.block.compressedSize) {
+          slot.input.resize(slot.block.compressedSize);
+        }
+        slot.inputSize = readFully(input.get(), slot.input.data(), slot.block.compressedSize, readOffset);
+        if (slot.inputSize != slot.block.compressedSize) {
+          throw std::runtime_error("Truncated block at offset " + std::to_string(readOffset));
+        }
+        readOffset += slot.inputSize;
+        return true;
+      },
+      [&](Slot & slot) {
+        BlockStatus status = decodeBlock(slot.block, slot.input.data(), header, slot.decoded, &cache,
+                                         options.decodeThreads);
+        if (status == BlockStatus::Corrupt) {
+          throw std::runtime_error("Corrupt block " + std::to_string(decodedBlocks));
+        }
+        if (status == BlockStatus::ChecksumMismatch) {
+          throw std::runtime_error("Checksum mismatch in block " + std::to_string(decodedBlocks));
+        }
+        decodedBlocks++;
+      },
+      [&](Slot & slot) {
+        writeFully(output.get(), reinterpret_cast<const uint8_t *>(slot.decoded.data()), slot.decoded.size(),
+                   writeOffset);
+        writeOffset += slot.decoded.size();
+      });
+  result.inputBytes = readOffset;
+  result.outputBytes = writeOffset;
+  return result;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+/**
+ * @brief Settings for the pipelined file compressor.
+ * queueDepth blocks are in flight at once (2 = double buffering, 3 = triple buffering), so
+ * reading block n + 1 and writing block n - 1 overlap compressing block n.
+ * */
+struct PipelineOptions {
+  size_t blockSize = 1 << 20;
+  int queueDepth = 3;
+  bool useIoUring = true; //io_uring when the kernel allows it, threads otherwise
+  int level = 0;          //compressLevel() level: 0 Huffman only, 1-3 LZ77 + Huffman
+  bool checksums = true;  //store and verify a CRC32C per block
+  bool staticTable = false; //code every block with the built-in static codebook instead of per-block tables
+  int decodeThreads = 0;  //threads per large level 0 block when decompressing, 0 = hardware concurrency
+  int lookupBits = 0;     //primary decode table width when decompressing, 0 = DEFAULT_LOOKUP_BITS
+};
+
+/**
+ * @brief What a pipelined run did, for reporting
+ * */
+struct PipelineResult {
+  size_t blocks = 0;
+  uint64_t inputBytes = 0;
+  uint64_t outputBytes = 0;
+  bool usedIoUring = false;
+};
+
+/**
+ * @brief compress a file block by block into the checksummed container described in container.h
+ * @params inputPath, outputPath, options
+ * @return PipelineResult, throws std::runtime_error on I/O errors
+ * */
+PipelineResult compressFile(const std::string & inputPath, const std::string & outputPath,
+                            const PipelineOptions & options = {});
+
+/**
+ * @brief decompress a file written by compressFile, reads/decompression/writes overlap on threads
+ * @params inputPath, outputPath, options (queueDepth, decodeThreads and lookupBits are used, blockSize comes from the file)
+ * @return PipelineResult, throws std::runtime_error on I/O errors, corrupt input or a checksum mismatch
+ * */
+PipelineResult decompressFile(const std::string & inputPath, const std::string & outputPath,
+                              const PipelineOptions & options = {});
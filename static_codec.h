@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <utility>
+
+#include "huffman.h"
+
+
+/**
+ * @brief Codebook computed entirely at compile time from a frequency table.
+ * The codes are the same canonical codes buildCanonicalCodes() assigns to these lengths, so a static
+ * stream can also be read by decodeBytes() given the lengths. There is no header: both sides know the table.
+ * MaxLength bounds the code length and sets the decode table to 2^MaxLength entries.
+ * */
+template <int MaxLength>
+struct StaticCodebook {
+  static_assert(MaxLength >= 8 && MaxLength <= MAX_CODE_LENGTH, "MaxLength must be 8..15");
+
+  std::array<uint8_t, ALPHABET_SIZE> lengths{};
+  std::array<uint32_t, ALPHABET_SIZE> encode{};      //code | len << 16, same layout as EncodeTable
+  std::array<uint16_t, (1u << MaxLength)> decode{};  //symbol | len << 8, indexed by the next MaxLength bits
+  int longest = 0;                                   //longest code actually used
+};
+
+/**
+ * @brief constexpr Huffman code lengths, same flatten-and-retry length limit as buildCodeLengths()
+ * Uses the two-queue construction (sorted leaves + internal nodes, which are created in weight order)
+ * instead of MinHeap so the whole build stays a cheap constant expression.
+ * */
+constexpr std::array<uint8_t, ALPHABET_SIZE> buildStaticLengths(const std::array<int, ALPHABET_SIZE> & frequency,
+                                                                int maxLength) {
+  std::array<int, ALPHABET_SIZE> current = frequency;
+
+  while (true) {
+    std::array<uint8_t, ALPHABET_SIZE> lengths{};
+
+    //Used symbols sorted by (frequency, symbol), insertion sort is fine for 256 entries
+    std::array<int, ALPHABET_SIZE> leaves{};
+    int leafCount = 0;
+    for (int symbol = 0; symbol < ALPHABET_SIZE; symbol++) {
+      if (current[static_cast<size_t>(symbol)] <= 0) {
+        continue;
+      }
+      int i = leafCount++;
+      while (i > 0 && current[static_cast<size_t>(leaves[static_cast<size_t>(i - 1)])] > current[static_cast<size_t>(symbol)]) {
+        leaves[static_cast<size_t>(i)] = leaves[static_cast<size_t>(i - 1)];
+        i--;
+      }
+      leaves[static_cast<size_t>(i)] = symbol;
+    }
+    if (leafCount == 0) {
+      return lengths;
+    }
+    if (leafCount == 1) {
+      lengths[static_cast<size_t>(leaves[0])] = 1;
+      return lengths;
+    }
+
+    //Nodes 0..255 are symbols, internal nodes are appended from 256 on
+    std::array<long long, 2 * ALPHABET_SIZE> weight{};
+    std::array<int, 2 * ALPHABET_SIZE> parent{};
+    for (int symbol = 0; symbol < ALPHABET_SIZE; symbol++) {
+      weight[static_cast<size_t>(symbol)] = current[static_cast<size_t>(symbol)];
+    }
+    int nextLeaf = 0;
+    int nextInternal = ALPHABET_SIZE;
+    int nodes = ALPHABET_SIZE;
+    auto takeLightest = [&] {
+      if (nextLeaf < leafCount &&
+          (nextInternal == nodes ||
+           weight[static_cast<size_t>(leaves[static_cast<size_t>(nextLeaf)])] <= weight[static_cast<size_t>(nextInternal)])) {
+        return leaves[static_cast<size_t>(nextLeaf++)];
+      }
+      return nextInternal++;
+    };
+    for (int merges = 0; merges < leafCount - 1; merges++) {
+      int left = takeLightest();
+      int right = takeLightest();
+      weight[static_cast<size_t>(nodes)] = weight[static_cast<size_t>(left)] + weight[static_cast<size_t>(right)];
+      parent[static_cast<size_t>(left)] = nodes;
+      parent[static_cast<size_t>(right)] = nodes;
+      nodes++;
+    }
+
+    //A parent always has a higher index than its internal children, so depths fill in walking down from the root
+    std::array<int, 2 * ALPHABET_SIZE> depth{};
+    for (int node = nodes - 2; node >= ALPHABET_SIZE; node--) {
+      depth[static_cast<size_t>(node)] = depth[static_cast<size_t>(parent[static_cast<size_t>(node)])] + 1;
+    }
+    int deepest = 0;
+    for (int i = 0; i < leafCount; i++) {
+      int symbol = leaves[static_cast<size_t>(i)];
+      int len = depth[static_cast<size_t>(parent[static_cast<size_t>(symbol)])] + 1;
+      lengths[static_cast<size_t>(symbol)] = static_cast<uint8_t>(std::min(len, 255));
+      deepest = std::max(deepest, len);
+    }
+    if (deepest <= maxLength) {
+      return lengths;
+    }
+
+    for (int & count : current) {
+      if (count > 0) {
+        count = (count >> 1) | 1;
+      }
+    }
+  }
+}
+
+/**
+ * @brief build the full static codebook: lengths, fused encode entries and a single-level decode table
+ * */
+template <int MaxLength>
+constexpr StaticCodebook<MaxLength> makeStaticCodebook(const std::array<int, ALPHABET_SIZE> & frequency) {
+  StaticCodebook<MaxLength> book;
+  book.lengths = buildStaticLengths(frequency, MaxLength);
+
+  //Canonical codes, same steps as buildCanonicalCodes()
+  std::array<uint32_t, MAX_CODE_LENGTH + 1> lengthCount{};
+  for (uint8_t len : book.lengths) {
+    lengthCount[len]++;
+  }
+  lengthCount[0] = 0;
+  std::array<uint32_t, MAX_CODE_LENGTH + 1> nextCode{};
+  uint32_t code = 0;
+  for (int bits = 1; bits <= MAX_CODE_LENGTH; bits++) {
+    code = (code + lengthCount[static_cast<size_t>(bits - 1)]) << 1;
+    nextCode[static_cast<size_t>(bits)] = code;
+  }
+
+  for (int symbol = 0; symbol < ALPHABET_SIZE; symbol++) {
+    int len = book.lengths[static_cast<size_t>(symbol)];
+    if (len == 0) {
+      continue;
+    }
+    uint32_t reversed = reverseBits(nextCode[static_cast<size_t>(len)]++, len);
+    book.encode[static_cast<size_t>(symbol)] = reversed | (static_cast<uint32_t>(len) << 16);
+    book.longest = std::max(book.longest, len);
+
+    //Every MaxLength-bit window whose low len bits are this code decodes to symbol
+    for (uint32_t index = reversed; index < (1u << MaxLength); index += 1u << len) {
+      book.decode[index] = static_cast<uint16_t>(symbol | (len << 8));
+    }
+  }
+  return book;
+}
+
+/**
+ * @brief encode with a compile-time codebook, output is bit-identical to encodeSymbols() with the same codes
+ * The number of symbols per 8-byte flush follows from the codebook's longest code and the loop is fully unrolled.
+ * out needs room for maxEncodedSize(data.size()) bytes.
+ * @return number of bytes written
+ * */
+template <const auto & Codebook>
+size_t staticEncode(std::span<const uint8_t> data, uint8_t * out) {
+  static_assert(std::endian::native == std::endian::little, "the 8-byte flush assumes a little-endian target");
+  //At most 7 bits are left after a flush, so 56 more fit in the 64-bit buffer
+  constexpr size_t perFlush = static_cast<size_t>(56 / Codebook.longest);
+  static_assert(perFlush * Codebook.longest + 7 <= 63, "a flush group must not fill the whole buffer");
+
+  const uint8_t * in = data.data();
+  const size_t size = data.size();
+  uint8_t * pos = out;
+  uint64_t buffer = 0;
+  uint32_t bitCount = 0;
+
+  auto put = [&](uint8_t byte) {
+    uint32_t entry = Codebook.encode[byte];
+    buffer |= static_cast<uint64_t>(entry & 0xFFFF) << bitCount;
+    bitCount += entry >> 16;
+  };
+  auto flush = [&] {
+    std::memcpy(pos, &buffer, sizeof(buffer));
+    pos += bitCount >> 3;
+    buffer >>= bitCount & ~7u;
+    bitCount &= 7;
+  };
+
+  size_t i = 0;
+  for (; i + perFlush <= size; i += perFlush) {
+    [&]<size_t... k>(std::index_sequence<k...>) {
+      (put(in[i + k]), ...);
+    }(std::make_index_sequence<perFlush>{});
+    flush();
+  }
+  for (; i < size; i++) {
+    put(in[i]);
+    flush();
+  }
+  std::memcpy(pos, &buffer, sizeof(buffer));
+  pos += (bitCount + 7) >> 3;
+  return static_cast<size_t>(pos - out);
+}
+
+/**
+ * @brief decode count symbols with a compile-time codebook
+ * One table lookup per symbol and no per-symbol bounds checks: past the end of the input zero bits
+ * are shifted in, and a single check at the end rejects streams that ran out.
+ * @return true on success, false if the input is too short for count symbols
+ * */
+template <const auto & Codebook>
+bool staticDecode(const uint8_t * in, size_t size, uint8_t * out, size_t count) {
+  constexpr int lookupBits = static_cast<int>(std::countr_zero(Codebook.decode.size()));
+  constexpr uint64_t lookupMask = (uint64_t{1} << lookupBits) - 1;
+  //The fast refill only guarantees 56 buffered bits
+  constexpr size_t perRefill = static_cast<size_t>(56 / Codebook.longest);
+  static_assert(perRefill * Codebook.longest <= 56, "a refill group must fit in the guaranteed bits");
+
+  uint64_t buffer = 0;
+  uint32_t bitCount = 0;
+  size_t pos = 0;
+
+  auto refill = [&] {
+    if (pos + 8 <= size) {
+      uint64_t word;
+      std::memcpy(&word, in + pos, sizeof(word));
+      buffer |= word << bitCount;
+      pos += (63 - bitCount) >> 3;
+      bitCount |= 56;
+    }
+    else {
+      //Slow path for the last bytes
+      while (bitCount <= 56) {
+        buffer |= static_cast<uint64_t>(pos < size ? in[pos] : 0) << bitCount;
+        pos++;
+        bitCount += 8;
+      }
+    }
+  };
+  auto take = [&](size_t index) {
+    uint16_t entry = Codebook.decode[buffer & lookupMask];
+    out[index] = static_cast<uint8_t>(entry);
+    buffer >>= entry >> 8;
+    bitCount -= entry >> 8;
+  };
+
+  size_t i = 0;
+  for (; i + perRefill <= count; i += perRefill) {
+    refill();
+    [&]<size_t... k>(std::index_sequence<k...>) {
+      (take(i + k), ...);
+    }(std::make_index_sequence<perRefill>{});
+  }
+  for (; i < count; i++) {
+    refill();
+    take(i);
+  }
+
+  //Bits actually consumed must fit in the input
+  return pos * 8 - bitCount <= size * 8;
+}